@@ -0,0 +1,536 @@
+//==============================================================
+// DPC++ Example
+//
+// GEMM library for Matrix Multiplication with DPC++
+//
+// C = A * B + C for row-major matrices whose shapes are given at run time:
+// A is M x K, B is K x N and C is M x N. As in BLAS, lda, ldb and ldc are
+// the leading dimensions, i.e. the distance in elements between two rows,
+// so a matrix can also be a block of a larger one.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-
+//
+// MIT License
+//
+#ifndef __GEMM_HPP__
+#define __GEMM_HPP__
+
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace sycl;
+
+// work-groups are GEMM_BLOCK_SIZE x GEMM_BLOCK_SIZE work-items; the tiled
+// kernel also steps through k by GEMM_BLOCK_SIZE
+#define GEMM_BLOCK_SIZE 16
+
+inline size_t round_up(size_t n, size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+//************************************
+// The rows x columns block at M with leading dimension ld, as a dense array
+//************************************
+// A block that is not dense already is copied to staging. Buffers over the
+// result then hold exactly the elements of the block, and never read or
+// write the elements of a larger matrix around it.
+inline const float *dense_block(const float *M, size_t rows, size_t columns, size_t ld,
+  std::vector<float> &staging)
+{
+  if (ld == columns)
+    return M;
+  staging.resize(rows * columns);
+  for (size_t r = 0; r < rows; r++)
+    std::copy(M + r * ld, M + r * ld + columns, staging.data() + r * columns);
+  return staging.data();
+}
+
+inline float *dense_block(float *M, size_t rows, size_t columns, size_t ld,
+  std::vector<float> &staging)
+{
+  return const_cast<float *>(dense_block((const float *)M, rows, columns, ld, staging));
+}
+
+// copy a block made dense by dense_block() back to M
+inline void write_back_block(const std::vector<float> &staging, float *M, size_t rows,
+  size_t columns, size_t ld)
+{
+  if (ld == columns)
+    return;
+  for (size_t r = 0; r < rows; r++)
+    std::copy(staging.data() + r * columns, staging.data() + (r + 1) * columns, M + r * ld);
+}
+
+// steps of k the register-blocked kernel loads from A as one vector
+#define GEMM_VEC_K 4
+
+// default block shape of the kernel on packed panels
+#define GEMM_PACKED_BM 8
+#define GEMM_PACKED_BN 4
+
+enum GemmKernel { GEMM_NAIVE, GEMM_TILED, GEMM_BLOCKED_4X4, GEMM_BLOCKED_8X4, GEMM_PACKED };
+constexpr GemmKernel GEMM_KERNELS[] = {GEMM_NAIVE, GEMM_TILED, GEMM_BLOCKED_4X4,
+                                       GEMM_BLOCKED_8X4, GEMM_PACKED};
+
+inline const char *gemm_kernel_name(GemmKernel kernel) {
+  switch (kernel) {
+    case GEMM_NAIVE: return "naive";
+    case GEMM_TILED: return "tiled";
+    case GEMM_BLOCKED_4X4: return "blocked4x4";
+    case GEMM_BLOCKED_8X4: return "blocked8x4";
+    case GEMM_PACKED: return "packed";
+  }
+  return "unknown";
+}
+
+//************************************
+// One work-item per element of C, reading A and B from global memory
+//************************************
+// Every work-item streams a whole row of A and column of B, so each
+// element loaded feeds a single multiply-add.
+event submit_gemm_naive(queue &q, size_t M, size_t N, size_t K, buffer<float, 2> &a_buf,
+  buffer<float, 2> &b_buf, buffer<float, 2> &c_buf)
+{
+  range<2> num_items{round_up(M, GEMM_BLOCK_SIZE), round_up(N, GEMM_BLOCK_SIZE)};
+  range<2> group_items{GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE};
+
+  return q.submit([&](handler &h) {
+    auto a = a_buf.get_access<access::mode::read>(h);
+    auto b = b_buf.get_access<access::mode::read>(h);
+    auto c = c_buf.get_access<access::mode::read_write>(h);
+
+    h.parallel_for<class gemm_naive_kernel>(nd_range<2>(num_items, group_items),
+      [=](nd_item<2> item)
+      [[intel::max_work_group_size(1, GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE)]]
+      {
+        size_t row = item.get_global_id(0), col = item.get_global_id(1);
+        if (row >= M || col >= N)
+          return;
+
+        float s = 0;
+        for (size_t k = 0; k < K; k++)
+          s += a[row][k] * b[k][col];
+        c[row][col] += s;
+      });
+  });
+}
+
+//************************************
+// One work-item per element of C, with tiles of A and B in local memory
+//************************************
+// For every step of GEMM_BLOCK_SIZE along k, the work-group loads a tile
+// of A and a tile of B into local memory, one element per work-item, and
+// every element of a tile is then read by GEMM_BLOCK_SIZE work-items. The
+// parts of the edge tiles outside of A or B are filled with zeros, so all
+// work-items take part in the loads and barriers.
+event submit_gemm_tiled(queue &q, size_t M, size_t N, size_t K, buffer<float, 2> &a_buf,
+  buffer<float, 2> &b_buf, buffer<float, 2> &c_buf)
+{
+  range<2> num_items{round_up(M, GEMM_BLOCK_SIZE), round_up(N, GEMM_BLOCK_SIZE)};
+  range<2> group_items{GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE};
+
+  return q.submit([&](handler &h) {
+    auto a = a_buf.get_access<access::mode::read>(h);
+    auto b = b_buf.get_access<access::mode::read>(h);
+    auto c = c_buf.get_access<access::mode::read_write>(h);
+    accessor<float, 2, access::mode::read_write, access::target::local> tile_a(group_items, h);
+    accessor<float, 2, access::mode::read_write, access::target::local> tile_b(group_items, h);
+
+    h.parallel_for<class gemm_tiled_kernel>(nd_range<2>(num_items, group_items),
+      [=](nd_item<2> item)
+      [[intel::max_work_group_size(1, GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE)]]
+      {
+        size_t row = item.get_global_id(0), col = item.get_global_id(1);
+        size_t m = item.get_local_id(0), n = item.get_local_id(1);
+
+        float s = 0;
+        for (size_t k0 = 0; k0 < K; k0 += GEMM_BLOCK_SIZE) {
+          tile_a[m][n] = row < M && k0 + n < K ? a[row][k0 + n] : 0;
+          tile_b[m][n] = k0 + m < K && col < N ? b[k0 + m][col] : 0;
+          item.barrier(access::fence_space::local_space);
+
+          #pragma unroll
+          for (size_t k = 0; k < GEMM_BLOCK_SIZE; k++)
+            s += tile_a[m][k] * tile_b[k][n];
+          // the tiles are overwritten in the next step
+          item.barrier(access::fence_space::local_space);
+        }
+        if (row < M && col < N)
+          c[row][col] += s;
+      });
+  });
+}
+
+template <int BM, int BN> class gemm_blocked_kernel;
+
+//************************************
+// One work-item per BM x BN block of C, accumulated in registers
+//************************************
+// For every GEMM_VEC_K steps of k, a work-item loads a vector of GEMM_VEC_K
+// elements from each of its BM rows of A and a vector of BN elements from
+// each of the GEMM_VEC_K rows of B, and does GEMM_VEC_K * BM * BN
+// multiply-adds with them, so each element loaded feeds BN or BM of them
+// instead of one. The block shape is a template parameter, so that the
+// best one for a device can be instantiated; BN must be a vector size (1,
+// 2, 4, 8 or 16). The last K % GEMM_VEC_K steps, and the blocks on the
+// bottom and right edges of C that may be partly outside of it, take the
+// slower path with a scalar load per row of A and a bounds check on every
+// load and store.
+template <int BM, int BN>
+event submit_gemm_blocked(queue &q, size_t M, size_t N, size_t K, buffer<float, 2> &a_buf,
+  buffer<float, 2> &b_buf, buffer<float, 2> &c_buf)
+{
+  static_assert(BN == 1 || BN == 2 || BN == 4 || BN == 8 || BN == 16,
+                "BN must be a vector size");
+  range<2> num_items{round_up((M + BM - 1) / BM, GEMM_BLOCK_SIZE),
+                     round_up((N + BN - 1) / BN, GEMM_BLOCK_SIZE)};
+  range<2> group_items{GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE};
+  size_t lda = a_buf.get_range()[1], ldb = b_buf.get_range()[1];
+
+  return q.submit([&](handler &h) {
+    auto a = a_buf.get_access<access::mode::read>(h);
+    auto b = b_buf.get_access<access::mode::read>(h);
+    auto c = c_buf.get_access<access::mode::read_write>(h);
+
+    h.parallel_for<gemm_blocked_kernel<BM, BN>>(nd_range<2>(num_items, group_items),
+      [=](nd_item<2> item)
+      [[intel::max_work_group_size(1, GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE)]]
+      {
+        size_t row = item.get_global_id(0) * BM, col = item.get_global_id(1) * BN;
+        if (row >= M || col >= N)
+          return;
+        bool inside = row + BM <= M && col + BN <= N;
+
+        float acc[BM][BN];
+        #pragma unroll
+        for (int i = 0; i < BM; i++)
+          #pragma unroll
+          for (int j = 0; j < BN; j++)
+            acc[i][j] = 0;
+
+        size_t k = 0;
+        if (inside)
+          for (; k + GEMM_VEC_K <= K; k += GEMM_VEC_K) {
+            vec<float, GEMM_VEC_K> a_rows[BM];
+            vec<float, BN> b_rows[GEMM_VEC_K];
+            #pragma unroll
+            for (int i = 0; i < BM; i++)
+              a_rows[i].load(0, a.get_pointer() + (row + i) * lda + k);
+            #pragma unroll
+            for (int kk = 0; kk < GEMM_VEC_K; kk++)
+              b_rows[kk].load(0, b.get_pointer() + (k + kk) * ldb + col);
+            #pragma unroll
+            for (int kk = 0; kk < GEMM_VEC_K; kk++)
+              #pragma unroll
+              for (int i = 0; i < BM; i++)
+                #pragma unroll
+                for (int j = 0; j < BN; j++)
+                  acc[i][j] += a_rows[i][kk] * b_rows[kk][j];
+          }
+
+        for (; k < K; k++) {
+          vec<float, BN> b_row;
+          if (inside)
+            b_row.load(0, b.get_pointer() + k * ldb + col);
+          else
+            for (int j = 0; j < BN; j++)
+              b_row[j] = col + j < N ? b[k][col + j] : 0;
+          #pragma unroll
+          for (int i = 0; i < BM; i++) {
+            float a_ik = inside || row + i < M ? a[row + i][k] : 0;
+            #pragma unroll
+            for (int j = 0; j < BN; j++)
+              acc[i][j] += a_ik * b_row[j];
+          }
+        }
+
+        #pragma unroll
+        for (int i = 0; i < BM; i++)
+          #pragma unroll
+          for (int j = 0; j < BN; j++)
+            if (inside || (row + i < M && col + j < N))
+              c[row + i][col + j] += acc[i][j];
+      });
+  });
+}
+
+//************************************
+// C = A * B + C on device with the kernel submitted by submit(q, M, N, K,
+// a_buf, b_buf, c_buf)
+//************************************
+template <typename Submit>
+void run_gemm(queue &q, size_t M, size_t N, size_t K, const float *A, size_t lda,
+  const float *B, size_t ldb, float *C, size_t ldc, Submit submit)
+{
+  if (lda < K || ldb < N || ldc < N)
+    throw "gemm: a leading dimension is smaller than the row length";
+  // C is unchanged when A * B is empty
+  if (M == 0 || N == 0 || K == 0)
+    return;
+
+  // The kernels see dense M x K, K x N and M x N matrices.
+  std::vector<float> a_staging, b_staging, c_staging;
+  const float *a_dense = dense_block(A, M, K, lda, a_staging);
+  const float *b_dense = dense_block(B, K, N, ldb, b_staging);
+  float *c_dense = dense_block(C, M, N, ldc, c_staging);
+  {
+    // The buffer destructor copies C back to host when it goes out of scope.
+    buffer<float, 2> a_buf(a_dense, range(M, K));
+    buffer<float, 2> b_buf(b_dense, range(K, N));
+    buffer<float, 2> c_buf(c_dense, range(M, N));
+
+    event e = submit(q, M, N, K, a_buf, b_buf, c_buf);
+
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    // Report profiling info
+    std::cout << "Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  }
+  write_back_block(c_staging, C, M, N, ldc);
+}
+
+template <int W> class pack_columns_kernel;
+template <int W> class pack_rows_kernel;
+template <int BM, int BN> class gemm_packed_kernel;
+
+//************************************
+// Pack the rows x columns matrix in src_buf into panels of W columns
+//************************************
+// Each panel is stored row after row, so element (k, j) goes to
+// panels[(j / W) * rows * W + k * W + j % W]; the columns past the right
+// edge of the last panel are zeros.
+template <int W>
+event submit_pack_columns(queue &q, buffer<float, 2> &src_buf, size_t rows, size_t columns,
+  buffer<float, 1> &panels_buf)
+{
+  return q.submit([&](handler &h) {
+    auto src = src_buf.get_access<access::mode::read>(h);
+    auto panels = panels_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<pack_columns_kernel<W>>(range<2>(rows, round_up(columns, W)),
+      [=](id<2> i)
+      { size_t k = i[0], j = i[1];
+        panels[(j / W) * rows * W + k * W + j % W] = j < columns ? src[k][j] : 0;
+      });
+  });
+}
+
+//************************************
+// Pack the rows x columns matrix in src_buf into panels of W rows
+//************************************
+// Each panel is stored column after column, so element (i, k) goes to
+// panels[(i / W) * columns * W + k * W + i % W]; the rows past the bottom
+// edge of the last panel are zeros.
+template <int W>
+event submit_pack_rows(queue &q, buffer<float, 2> &src_buf, size_t rows, size_t columns,
+  buffer<float, 1> &panels_buf)
+{
+  return q.submit([&](handler &h) {
+    auto src = src_buf.get_access<access::mode::read>(h);
+    auto panels = panels_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<pack_rows_kernel<W>>(range<2>(round_up(rows, W), columns),
+      [=](id<2> i)
+      { size_t r = i[0], k = i[1];
+        panels[(r / W) * columns * W + k * W + r % W] = r < rows ? src[r][k] : 0;
+      });
+  });
+}
+
+//************************************
+// One work-item per BM x BN block of C, from A and B packed into panels
+//************************************
+// The register-blocked kernel again, but the BM elements of A and the BN
+// elements of B it needs for every k are next to each other in the panels,
+// and so are those for the next k: each work-item reads its A panel and B
+// panel from start to end, with vector loads and no bounds checks.
+template <int BM, int BN>
+event submit_gemm_packed(queue &q, size_t M, size_t N, size_t K,
+  buffer<float, 1> &a_panels_buf, buffer<float, 1> &b_panels_buf, buffer<float, 2> &c_buf)
+{
+  static_assert((BM == 1 || BM == 2 || BM == 4 || BM == 8 || BM == 16) &&
+                (BN == 1 || BN == 2 || BN == 4 || BN == 8 || BN == 16),
+                "BM and BN must be vector sizes");
+  range<2> num_items{round_up((M + BM - 1) / BM, GEMM_BLOCK_SIZE),
+                     round_up((N + BN - 1) / BN, GEMM_BLOCK_SIZE)};
+  range<2> group_items{GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE};
+
+  return q.submit([&](handler &h) {
+    auto a_panels = a_panels_buf.get_access<access::mode::read>(h);
+    auto b_panels = b_panels_buf.get_access<access::mode::read>(h);
+    auto c = c_buf.get_access<access::mode::read_write>(h);
+
+    h.parallel_for<gemm_packed_kernel<BM, BN>>(nd_range<2>(num_items, group_items),
+      [=](nd_item<2> item)
+      [[intel::max_work_group_size(1, GEMM_BLOCK_SIZE, GEMM_BLOCK_SIZE)]]
+      {
+        size_t a_panel = item.get_global_id(0), b_panel = item.get_global_id(1);
+        size_t row = a_panel * BM, col = b_panel * BN;
+        if (row >= M || col >= N)
+          return;
+        auto a_ptr = a_panels.get_pointer() + a_panel * K * BM;
+        auto b_ptr = b_panels.get_pointer() + b_panel * K * BN;
+
+        float acc[BM][BN];
+        #pragma unroll
+        for (int i = 0; i < BM; i++)
+          #pragma unroll
+          for (int j = 0; j < BN; j++)
+            acc[i][j] = 0;
+
+        for (size_t k = 0; k < K; k++) {
+          vec<float, BM> a_column;
+          vec<float, BN> b_row;
+          a_column.load(k, a_ptr);
+          b_row.load(k, b_ptr);
+          #pragma unroll
+          for (int i = 0; i < BM; i++)
+            #pragma unroll
+            for (int j = 0; j < BN; j++)
+              acc[i][j] += a_column[i] * b_row[j];
+        }
+
+        #pragma unroll
+        for (int i = 0; i < BM; i++)
+          #pragma unroll
+          for (int j = 0; j < BN; j++)
+            if (row + i < M && col + j < N)
+              c[row + i][col + j] += acc[i][j];
+      });
+  });
+}
+
+// B packed into panels of panel_width columns, kept on device so that it
+// can be multiplied with many A matrices
+struct PackedB {
+  size_t K;
+  size_t N;
+  int panel_width;
+  buffer<float, 1> panels;
+};
+
+//************************************
+// Pack B for gemm_packed() with blocks BN columns wide
+//************************************
+template <int BN = GEMM_PACKED_BN>
+PackedB pack_b(queue &q, size_t K, size_t N, const float *B, size_t ldb)
+{
+  if (ldb < N)
+    throw "gemm: a leading dimension is smaller than the row length";
+  PackedB packed{K, N, BN, buffer<float, 1>(range<1>(std::max<size_t>(1, K * round_up(N, BN))))};
+  if (K == 0 || N == 0)
+    return packed;
+  // the host copy of B is no longer needed once this buffer is destroyed
+  std::vector<float> b_staging;
+  buffer<float, 2> b_buf(dense_block(B, K, N, ldb, b_staging), range(K, N));
+  submit_pack_columns<BN>(q, b_buf, K, N, packed.panels);
+  return packed;
+}
+
+//************************************
+// C = A * B + C on device, with B packed by pack_b()
+//************************************
+// A is packed into panels of BM rows on the way, which costs one pass over
+// A against the M * N * K multiply-adds.
+template <int BM = GEMM_PACKED_BM, int BN = GEMM_PACKED_BN>
+void gemm_packed(queue &q, size_t M, const float *A, size_t lda, const PackedB &b,
+  float *C, size_t ldc)
+{
+  size_t N = b.N, K = b.K;
+  if (b.panel_width != BN)
+    throw "gemm: B was packed for another block width";
+  if (lda < K || ldc < N)
+    throw "gemm: a leading dimension is smaller than the row length";
+  // C is unchanged when A * B is empty
+  if (M == 0 || N == 0 || K == 0)
+    return;
+
+  // as in run_gemm(), the buffers see dense M x K and M x N matrices
+  std::vector<float> a_staging, c_staging;
+  const float *a_dense = dense_block(A, M, K, lda, a_staging);
+  float *c_dense = dense_block(C, M, N, ldc, c_staging);
+  {
+    buffer<float, 2> a_buf(a_dense, range(M, K));
+    buffer<float, 1> a_panels_buf{range<1>(round_up(M, BM) * K)};
+    buffer<float, 1> b_panels_buf = b.panels;
+    buffer<float, 2> c_buf(c_dense, range(M, N));
+
+    submit_pack_rows<BM>(q, a_buf, M, K, a_panels_buf);
+    event e = submit_gemm_packed<BM, BN>(q, M, N, K, a_panels_buf, b_panels_buf, c_buf);
+
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    // Report profiling info
+    std::cout << "Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  }
+  write_back_block(c_staging, C, M, N, ldc);
+}
+
+//************************************
+// C = A * B + C on device
+//************************************
+// The global range is rounded up to whole work-groups, so the work-groups
+// on the bottom and right edges of C may be partly outside of it; their
+// work-items past the edge have nothing to write. Any M, N and K work.
+void gemm(queue &q, size_t M, size_t N, size_t K, const float *A, size_t lda,
+  const float *B, size_t ldb, float *C, size_t ldc, GemmKernel kernel = GEMM_TILED)
+{
+  switch (kernel) {
+    case GEMM_NAIVE:
+      run_gemm(q, M, N, K, A, lda, B, ldb, C, ldc, submit_gemm_naive);
+      break;
+    case GEMM_TILED:
+      run_gemm(q, M, N, K, A, lda, B, ldb, C, ldc, submit_gemm_tiled);
+      break;
+    case GEMM_BLOCKED_4X4:
+      run_gemm(q, M, N, K, A, lda, B, ldb, C, ldc, submit_gemm_blocked<4, 4>);
+      break;
+    case GEMM_BLOCKED_8X4:
+      run_gemm(q, M, N, K, A, lda, B, ldb, C, ldc, submit_gemm_blocked<8, 4>);
+      break;
+    case GEMM_PACKED:
+      gemm_packed(q, M, A, lda, pack_b(q, K, N, B, ldb), C, ldc);
+      break;
+  }
+}
+
+// C = A * B + C with the register-blocked kernel of any block shape
+template <int BM, int BN>
+void gemm_blocked(queue &q, size_t M, size_t N, size_t K, const float *A, size_t lda,
+  const float *B, size_t ldb, float *C, size_t ldc)
+{
+  run_gemm(q, M, N, K, A, lda, B, ldb, C, ldc, submit_gemm_blocked<BM, BN>);
+}
+
+//************************************
+// C = A * B + C on host, used to validate the device results
+//************************************
+void gemm_host(size_t M, size_t N, size_t K, const float *A, size_t lda,
+  const float *B, size_t ldb, float *C, size_t ldc)
+{
+  for (size_t i = 0; i < M; i++)
+    for (size_t j = 0; j < N; j++) {
+      float s = 0;
+      for (size_t k = 0; k < K; k++)
+        s += A[i * lda + k] * B[k * ldb + j];
+      C[i * ldc + j] += s;
+    }
+}
+
+#endif
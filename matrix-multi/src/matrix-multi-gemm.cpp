@@ -0,0 +1,196 @@
+//==============================================================
+// DPC++ Example
+//
+// Matrix Multiplication with DPC++, shapes given at run time
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-
+//
+// MIT License
+//
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "dpc_common.hpp"
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+#include <sycl/ext/intel/fpga_extensions.hpp>
+#endif
+#include "gemm.hpp"
+
+using namespace sycl;
+
+//************************************
+// Multiply A, B and C as blocks of larger matrices and validate the result
+//************************************
+// Each block starts BLOCK_OFFSET rows down and BLOCK_OFFSET columns in, and
+// BLOCK_OFFSET more columns are left on its right, so the leading
+// dimensions are larger than the row lengths and the last row of a block
+// ends before the end of its matrix. The elements around the block of C
+// must come back untouched.
+constexpr size_t BLOCK_OFFSET = 3;
+
+bool multiply_blocks(queue &q, GemmKernel kernel, size_t M, size_t N, size_t K,
+  const std::vector<float> &A, const std::vector<float> &B, const std::vector<float> &C,
+  const std::vector<float> &sum_sequential)
+{
+  const float outside = -7;
+  size_t lda = K + 2 * BLOCK_OFFSET, ldb = N + 2 * BLOCK_OFFSET, ldc = N + 2 * BLOCK_OFFSET;
+  std::vector<float> a_matrix((M + BLOCK_OFFSET) * lda, outside);
+  std::vector<float> b_matrix((K + BLOCK_OFFSET) * ldb, outside);
+  std::vector<float> c_matrix((M + BLOCK_OFFSET) * ldc, outside);
+  float *a_block = a_matrix.data() + BLOCK_OFFSET * lda + BLOCK_OFFSET;
+  float *b_block = b_matrix.data() + BLOCK_OFFSET * ldb + BLOCK_OFFSET;
+  float *c_block = c_matrix.data() + BLOCK_OFFSET * ldc + BLOCK_OFFSET;
+  for (size_t i = 0; i < M; i++)
+    std::copy(&A[i * K], &A[i * K] + K, a_block + i * lda);
+  for (size_t k = 0; k < K; k++)
+    std::copy(&B[k * N], &B[k * N] + N, b_block + k * ldb);
+  for (size_t i = 0; i < M; i++)
+    std::copy(&C[i * N], &C[i * N] + N, c_block + i * ldc);
+
+  gemm(q, M, N, K, a_block, lda, b_block, ldb, c_block, ldc, kernel);
+
+  for (size_t i = 0; i < M + BLOCK_OFFSET; i++)
+    for (size_t j = 0; j < ldc; j++) {
+      bool inside = i >= BLOCK_OFFSET && j >= BLOCK_OFFSET && j < BLOCK_OFFSET + N;
+      float expected = inside ? sum_sequential[(i - BLOCK_OFFSET) * N + j - BLOCK_OFFSET]
+                              : outside;
+      if (std::abs(c_matrix[i * ldc + j] - expected) > 0.001) {
+        std::cout << "not equal with leading dimensions " << lda << ", " << ldb << ", "
+                  << ldc << std::endl;
+        std::cout << i << " " << j << " " << expected << " " << c_matrix[i * ldc + j]
+                  << std::endl;
+        return false;
+      }
+    }
+  return true;
+}
+
+//************************************
+// Multiply matrices of the shapes given on the command line on device and
+// validate the result on host.
+//************************************
+// usage: matrix-multi-gemm [-v kernel] [M N K]
+//   D = A * B + C with A: M x K, B: K x N, C and D: M x N; the default
+//   shapes are those of the other matrix-multi examples
+//   Every kernel also multiplies the matrices as blocks of larger ones.
+//   -v : run only the named kernel (naive, tiled, blocked4x4, blocked8x4,
+//        packed) instead of all of them
+int main(int argc, char **argv) {
+  // Create device selector for the device of your interest.
+#if FPGA_EMULATOR
+  // DPC++ extension: FPGA emulator selector on systems without FPGA card.
+  ext::intel::fpga_emulator_selector d_selector;
+#elif defined(FPGA) || defined(FPGA_PROFILE)
+  // DPC++ extension: FPGA selector on systems with FPGA card.
+  ext::intel::fpga_selector d_selector;
+#else
+  // The default device selector will select the most performant device.
+  default_selector d_selector;
+  //cpu_selector d_selector;
+#endif
+
+  size_t M = 800, N = 3200, K = 1600;
+  std::vector<GemmKernel> kernels(std::begin(GEMM_KERNELS), std::end(GEMM_KERNELS));
+  int a = 1;
+  if (a + 1 < argc && strcmp(argv[a], "-v") == 0) {
+    kernels.clear();
+    for (GemmKernel kernel : GEMM_KERNELS)
+      if (strcmp(argv[a + 1], gemm_kernel_name(kernel)) == 0)
+        kernels.push_back(kernel);
+    a += 2;
+  }
+  if (argc - a == 3) {
+    M = strtoul(argv[a], NULL, 10);
+    N = strtoul(argv[a + 1], NULL, 10);
+    K = strtoul(argv[a + 2], NULL, 10);
+  }
+  if ((argc != a && argc - a != 3) || kernels.empty()) {
+    std::cout << "usage: " << argv[0] << " [-v kernel] [M N K]" << std::endl;
+    return -1;
+  }
+
+  // Small integer values keep every sum exact in float, whatever the
+  // order of the additions, and differ from element to element so that a
+  // wrong row or column at the edges shows up.
+  std::vector<float> A(M * K), B(K * N), C(M * N);
+  for (size_t i = 0; i < M; i++)
+    for (size_t k = 0; k < K; k++) A[i * K + k] = (float)((i * 3 + k) % 5);
+  for (size_t k = 0; k < K; k++)
+    for (size_t j = 0; j < N; j++) B[k * N + j] = (float)((k + j * 2) % 7) - 3;
+  for (size_t i = 0; i < M; i++)
+    for (size_t j = 0; j < N; j++) C[i * N + j] = (float)((i + j) % 4);
+  std::vector<float> sum_sequential(C);
+
+  std::cout << "Matrix A size: " << M << "," << K << std::endl;
+  std::cout << "Matrix B size: " << K << "," << N << std::endl;
+  std::cout << "Matrices C, D size: " << M << "," << N << std::endl;
+
+#ifndef FPGA_PROFILE
+  // Start the timer (using std::chrono)
+  dpc_common::TimeInterval exec_time;
+
+  std::cout << "computing on host..." << std::endl;
+  gemm_host(M, N, K, A.data(), K, B.data(), N, sum_sequential.data(), N);
+
+  double host_time_s = exec_time.Elapsed();
+  std::cout << "host compute time " << host_time_s * 1000 << " ms\n";
+#endif
+
+  try {
+    queue q(d_selector, dpc_common::exception_handler,
+            property::queue::enable_profiling{});
+
+    // Print out the device information used for the kernel code.
+    std::cout << "Running on device: "
+              << q.get_device().get_info<info::device::name>() << "\n";
+
+    for (GemmKernel kernel : kernels) {
+      std::cout << "MatrixMultiplication using the " << gemm_kernel_name(kernel)
+                << " gemm kernel." << std::endl;
+      std::vector<float> sum_parallel(C);
+      if (kernel == GEMM_PACKED) {
+        // B is packed once, then multiplied without packing it again
+        dpc_common::TimeInterval pack_time;
+        PackedB packed_b = pack_b(q, K, N, B.data(), N);
+        std::cout << "B packing time " << pack_time.Elapsed() * 1000 << " ms\n";
+        dpc_common::TimeInterval device_time;
+        gemm_packed(q, M, A.data(), K, packed_b, sum_parallel.data(), N);
+        std::cout << "device compute time " << device_time.Elapsed() * 1000 << " ms\n";
+      } else {
+        dpc_common::TimeInterval device_time;
+        gemm(q, M, N, K, A.data(), K, B.data(), N, sum_parallel.data(), N, kernel);
+        std::cout << "device compute time " << device_time.Elapsed() * 1000 << " ms\n";
+      }
+
+#ifndef FPGA_PROFILE
+      // Verify that the two arrays are equal.
+      for (size_t i = 0; i < M; i++)
+        for (size_t j = 0; j < N; j++)
+          if (std::abs(sum_sequential[i * N + j] - sum_parallel[i * N + j]) > 0.001) {
+            std::cout << "not equal" << std::endl;
+            std::cout << i << " " << j << " " << sum_sequential[i * N + j]
+                      << " " << sum_parallel[i * N + j] << std::endl;
+            return -1;
+          }
+      if (!multiply_blocks(q, kernel, M, N, K, A, B, C, sum_sequential))
+        return -1;
+      std::cout << "Matrix multiplication successfully completed on device.\n";
+#endif
+    }
+
+  } catch (exception const &e) {
+    std::cout << "An exception is caught for matrix multiplication.\n";
+    std::terminate();
+  } catch (const char *msg) {
+    std::cout << msg << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
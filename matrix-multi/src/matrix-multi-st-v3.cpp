@@ -40,14 +40,9 @@ constexpr size_t b_columns = 3200;
 #endif
 
 class MMstv3;
-class MMstv3_cplusd;
 
 void MatrixMulti_st_v3(queue &q, float (*matrix_a)[a_columns], float (*matrix_b)[b_columns], 
   float (*matrix_c)[b_columns], float (*matrix_d_parallel)[b_columns]) {
-#if FPGA || FPGA_PROFILE
-  double kernel_time_ns, total_kernel_time_ns = 0;
-#endif
-
   std::cout << "MatrixMultiplication using single_task() v3." << std::endl;
 
   // Create the range object for the arrays managed by the buffer.
@@ -61,7 +56,6 @@ void MatrixMulti_st_v3(queue &q, float (*matrix_a)[a_columns], float (*matrix_b)
   buffer<float, 2> c_buf(reinterpret_cast<float *>(matrix_c), num_items);
   buffer<float, 2> sum_buf(reinterpret_cast<float *>(matrix_d_parallel), num_items);
 
-  auto step = 0;
   // Submit a command group to the queue by a lambda function that contains the
   // data access permission and device computation (kernel).
   event e = q.submit([&](handler &h) {
@@ -69,7 +63,8 @@ void MatrixMulti_st_v3(queue &q, float (*matrix_a)[a_columns], float (*matrix_b)
     // read/write. The accessor is a mean to access the memory in the buffer.
     auto a = a_buf.get_access<access::mode::read, access::target::global_buffer>(h);
     auto b = b_buf.get_access<access::mode::read, access::target::global_buffer>(h);
-    auto d = sum_buf.get_access<access::mode::read_write, access::target::global_buffer>(h);
+    auto c = c_buf.get_access<access::mode::read, access::target::global_buffer>(h);
+    auto d = sum_buf.get_access<access::mode::discard_write, access::target::global_buffer>(h);
       
 
     // A kernel that is executed on one thread using NDRange(1,1,1) is enqueued 
@@ -77,99 +72,59 @@ void MatrixMulti_st_v3(queue &q, float (*matrix_a)[a_columns], float (*matrix_b)
     //   single_task<typename kernel_lambda_name>([=](){});
     h.single_task<MMstv3>([=]() [[intel::kernel_args_restrict]]
     { 
-      size_t row, col, m, n, k;
+      size_t m, n, k;
       float s = 0;
-          // allocate local memory to hold a block of data from A, B
+          // allocate local memory to hold a block of data from A, B and D
 	        [[intel::numbanks(NUM_BANKS), intel::bankwidth(BANK_WIDTH)]] float local_mem_a[BLOCK_SIZE][BLOCK_SIZE];
 	        [[intel::numbanks(NUM_BANKS), intel::bankwidth(BANK_WIDTH)]] float local_mem_b[BLOCK_SIZE][BLOCK_SIZE];
 	        [[intel::numbanks(NUM_BANKS), intel::bankwidth(BANK_WIDTH)]] float local_mem_d[BLOCK_SIZE][BLOCK_SIZE];
 
-      for(int i=0; i < a_rows*a_columns/(BLOCK_SIZE*BLOCK_SIZE); i++) {
-        // the block indices of the block in A 
-        auto block_row_a = i / (a_columns/BLOCK_SIZE);
-        auto block_col_a = i % (a_columns/BLOCK_SIZE);
-        // we need to calculate dot-product with all the blocks in B where
-        // the row number is equal to block_col_a
-        auto block_row_b = block_col_a;
-        for(int j=0; j<b_columns/BLOCK_SIZE; j++)
-        { 
-
-          // load blocks of data to local memory from global memory
+      // one block of D at a time; the block stays in local memory while
+      // the products of all the blocks along k are added to it
+      for(int i=0; i < a_rows/BLOCK_SIZE; i++) {
+        for(int j=0; j < b_columns/BLOCK_SIZE; j++) {
+          // the block of D starts out as the block of C
           for (m=0; m < BLOCK_SIZE; m++)
             for ( n=0; n < BLOCK_SIZE; n++)
-            {
-              local_mem_a[m][n] = a[block_row_a*BLOCK_SIZE + m][block_col_a*BLOCK_SIZE + n];
-              local_mem_b[m][n] = b[block_row_b*BLOCK_SIZE + m][j*BLOCK_SIZE + n];
-              local_mem_d[m][n] = d[block_row_a*BLOCK_SIZE + m][j*BLOCK_SIZE + n];
-            }  
-          // element-wise multiplication and accumulation
-          for (m=0; m < BLOCK_SIZE; m++)
-            for ( n=0; n < BLOCK_SIZE; n++) {
-              s = 0;
-	      // #pragma unroll
-              for (k=0; k < BLOCK_SIZE; k++)
-                s += local_mem_a[m][k] * local_mem_b[k][n]; 
-              // add to Matrix D
-              // the corresponding row and col in D
-              row = block_row_a * BLOCK_SIZE + m;
-              col = j * BLOCK_SIZE + n;
-              //d[row][col] += s;
-              local_mem_d[m][n] += s;
-            }
-
-          // write d back to global memory
+              local_mem_d[m][n] = c[i*BLOCK_SIZE + m][j*BLOCK_SIZE + n];
+
+          // block (i, kb) of A times block (kb, j) of B
+          for(int kb=0; kb < a_columns/BLOCK_SIZE; kb++) {
+            // load blocks of data to local memory from global memory
+            for (m=0; m < BLOCK_SIZE; m++)
+              for ( n=0; n < BLOCK_SIZE; n++)
+              {
+                local_mem_a[m][n] = a[i*BLOCK_SIZE + m][kb*BLOCK_SIZE + n];
+                local_mem_b[m][n] = b[kb*BLOCK_SIZE + m][j*BLOCK_SIZE + n];
+              }
+            // element-wise multiplication and accumulation
+            for (m=0; m < BLOCK_SIZE; m++)
+              for ( n=0; n < BLOCK_SIZE; n++) {
+                s = 0;
+                // #pragma unroll
+                for (k=0; k < BLOCK_SIZE; k++)
+                  s += local_mem_a[m][k] * local_mem_b[k][n]; 
+                local_mem_d[m][n] += s;
+              }
+          } // for kb
+
+          // write the finished block of D to global memory, once
           for (m=0; m < BLOCK_SIZE; m++)
             for ( n=0; n < BLOCK_SIZE; n++)
-            {
-                d[block_row_a*BLOCK_SIZE + m][j*BLOCK_SIZE + n] = local_mem_d[m][n] ;
-            }  
+              d[i*BLOCK_SIZE + m][j*BLOCK_SIZE + n] = local_mem_d[m][n];
         } // for j
       } // for i
     }); // h
   }); // event e
-#if FPGA || FPGA_PROFILE
-      // Query event e for kernel profiling information
-      // (blocks until command groups associated with e complete)
-      kernel_time_ns =
-        e.get_profiling_info<info::event_profiling::command_end>() -
-        e.get_profiling_info<info::event_profiling::command_start>();
-
-      // Report profiling info
-      // step++;
-      //std::cout << "step " << step <<" Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
-
-      total_kernel_time_ns += kernel_time_ns;
-#endif
-
-  //
-  e = q.submit([&](handler &h) {
-    auto c = c_buf.get_access<access::mode::read, access::target::global_buffer>(h);
-    auto d = sum_buf.get_access<access::mode::write, access::target::global_buffer>(h);
-      
-    h.single_task<MMstv3_cplusd>([=]() [[intel::kernel_args_restrict]]
-    { 
-      size_t row, col, m, n, k;
-
-      // load blocks of data to local memory from global memory
-      for (m=0; m < a_rows; m++)
-        for ( n=0; n < b_columns; n++)
-          d[m][n] += c[m][n];
-    });
-  }); // event e
 #if FPGA || FPGA_PROFILE
   // Query event e for kernel profiling information
   // (blocks until command groups associated with e complete)
-  kernel_time_ns =
+  double kernel_time_ns =
     e.get_profiling_info<info::event_profiling::command_end>() -
     e.get_profiling_info<info::event_profiling::command_start>();
 
   // Report profiling info
-  //std::cout << " Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
-
-  total_kernel_time_ns += kernel_time_ns;
-
-  // Report profiling info as it takes multiple steps
-  std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+  std::cout << " Total Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
 #endif
 }
 
@@ -0,0 +1,241 @@
+//==============================================================
+// DPC++ Example
+//
+// Aho-Corasick multi-keyword search for Word Count
+//
+// The keyword set is compiled on the host into a deterministic automaton
+// (the trie's goto function with the failure links folded in) and copied
+// to the device as one flat transition table. Every text byte then costs a
+// single table lookup, however many keywords are being searched.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __AHO_CORASICK_HPP__
+#define __AHO_CORASICK_HPP__
+
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <string>
+#include <vector>
+#include "word-count.hpp"
+
+// The top bit of a transition marks a target state whose output set is not
+// empty, i.e. the state itself or one of its failure ancestors ends a keyword.
+constexpr uint32_t AC_MATCH_FLAG = 0x80000000u;
+constexpr uint32_t AC_STATE_MASK = ~AC_MATCH_FLAG;
+
+struct ACAutomaton {
+  std::vector<std::string> keywords;
+  size_t max_keyword_len = 0;
+  uint32_t num_states = 0;
+  // bytes that never appear in a keyword share class 0, every other byte
+  // value gets a class of its own; this keeps the table num_states * num_classes
+  uint32_t num_classes = 0;
+  std::vector<uint16_t> byte_class;     // 256 entries
+  std::vector<uint32_t> delta;          // num_states * num_classes transitions
+  std::vector<uint32_t> fail;           // failure link of each state
+  std::vector<uint32_t> bfs_order;      // states in breadth-first order
+  std::vector<uint32_t> keyword_state;  // state reached at the end of each keyword
+};
+
+//************************************
+// Read one keyword per line, empty lines are skipped
+//************************************
+std::vector<std::string> read_keyword_file(const char *path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    perror("Couldn't find the keyword file");
+    exit(1);
+  }
+  std::vector<std::string> keywords;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (!line.empty())
+      keywords.push_back(line);
+  }
+  return keywords;
+}
+
+//************************************
+// Build the automaton on host
+//************************************
+ACAutomaton build_ac_automaton(const std::vector<std::string> &keywords) {
+  ACAutomaton ac;
+  ac.keywords = keywords;
+  ac.byte_class.assign(256, 0);
+
+  ac.num_classes = 1;
+  for (auto &w : keywords) {
+    ac.max_keyword_len = std::max(ac.max_keyword_len, w.size());
+    for (unsigned char c : w)
+      if (ac.byte_class[c] == 0)
+        ac.byte_class[c] = ac.num_classes++;
+  }
+  const uint32_t nc = ac.num_classes;
+
+  // goto function of the keyword trie; 0 means "no edge" since the root
+  // (state 0) is never the child of another state
+  std::vector<uint32_t> trie(nc, 0);
+  std::vector<bool> output(1, false);
+  ac.num_states = 1;
+  for (auto &w : keywords) {
+    uint32_t s = 0;
+    for (unsigned char c : w) {
+      uint32_t &t = trie[(size_t)s * nc + ac.byte_class[c]];
+      if (t == 0) {
+        t = ac.num_states++;
+        trie.resize((size_t)ac.num_states * nc, 0);
+        output.push_back(false);
+      }
+      s = trie[(size_t)s * nc + ac.byte_class[c]];
+    }
+    output[s] = true;
+    ac.keyword_state.push_back(s);
+  }
+  if (ac.num_states > AC_STATE_MASK)
+    throw std::length_error("too many Aho-Corasick states");
+
+  // breadth-first pass computing failure links and the full transition table
+  ac.delta.assign((size_t)ac.num_states * nc, 0);
+  ac.fail.assign(ac.num_states, 0);
+  std::queue<uint32_t> pending;
+  pending.push(0);
+  while (!pending.empty()) {
+    uint32_t s = pending.front();
+    pending.pop();
+    ac.bfs_order.push_back(s);
+    for (uint32_t c = 0; c < nc; c++) {
+      uint32_t t = trie[(size_t)s * nc + c];
+      if (t != 0) {
+        ac.fail[t] = (s == 0) ? 0 : ac.delta[(size_t)ac.fail[s] * nc + c];
+        if (output[ac.fail[t]])
+          output[t] = true;
+        ac.delta[(size_t)s * nc + c] = t;
+        pending.push(t);
+      } else {
+        ac.delta[(size_t)s * nc + c] = (s == 0) ? 0 : ac.delta[(size_t)ac.fail[s] * nc + c];
+      }
+    }
+  }
+
+  for (auto &t : ac.delta)
+    if (output[t])
+      t |= AC_MATCH_FLAG;
+
+  return ac;
+}
+
+//************************************
+// Turn per-state hit counts into per-keyword counts
+//************************************
+// A hit is recorded only for the state reached at a text position. Keywords
+// that end at that position but are proper suffixes of the state's string
+// sit on its failure chain, so hits are pushed down the failure links in
+// reverse breadth-first order (deepest states first).
+void ac_collect_counts(const ACAutomaton &ac, std::vector<uint32_t> &hits,
+  std::vector<uint32_t> &counts)
+{
+  for (auto s = ac.bfs_order.rbegin(); s != ac.bfs_order.rend(); ++s)
+    if (*s != 0)
+      hits[ac.fail[*s]] += hits[*s];
+
+  counts.resize(ac.keywords.size());
+  for (size_t k = 0; k < ac.keywords.size(); k++)
+    counts[k] = hits[ac.keyword_state[k]];
+}
+
+//************************************
+// Aho-Corasick keyword count in DPC++ on device:
+//************************************
+void ac_search(queue &q, uint32_t n_wgroups, int wgroup_size, const ACAutomaton &ac,
+  const char *text, size_t text_size, size_t chars_per_item, std::vector<uint32_t> &counts)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  std::vector<uint32_t> hits(ac.num_states, 0);
+
+  {
+    buffer<char, 1> text_buf(text, range<1>(text_size));
+    buffer<uint16_t, 1> class_buf(ac.byte_class.data(), range<1>(ac.byte_class.size()));
+    buffer<uint32_t, 1> delta_buf(ac.delta.data(), range<1>(ac.delta.size()));
+    buffer<uint32_t, 1> hits_buf(hits.data(), range<1>(hits.size()));
+
+    std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+    std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+    event e = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto byte_class = class_buf.get_access<access::mode::read>(h);
+      auto delta = delta_buf.get_access<access::mode::read>(h);
+      auto hits_mem = hits_buf.get_access<access::mode::read_write>(h);
+
+      auto text_max_len = text_size;
+      auto num_classes = ac.num_classes;
+      // a keyword ending in this item's slice may start up to
+      // max_keyword_len-1 bytes before it, so each item rewinds by that much
+      // and only counts the matches that end inside its own slice
+      auto halo = ac.max_keyword_len - 1;
+
+      h.parallel_for<class ac_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t global_id = item.get_global_id(0);
+          size_t begin = global_id * chars_per_item;
+          size_t end = begin + chars_per_item;
+          if (end > text_max_len)
+            end = text_max_len;
+
+          uint32_t state = 0;
+          for (size_t i = (begin > halo ? begin - halo : 0); i < end; i++) {
+            uint32_t next = delta[(size_t)state * num_classes + byte_class[(unsigned char)text_mem[i]]];
+            state = next & AC_STATE_MASK;
+            if ((next & AC_MATCH_FLAG) && i >= begin)
+              global_atomic_ref<uint32_t>(hits_mem[state])++;
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    total_kernel_time_ns += kernel_time_ns;
+
+    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // buffers copy the hit counts back to host here
+
+  ac_collect_counts(ac, hits, counts);
+}
+
+//************************************
+// Aho-Corasick keyword count on host, used to validate the device results
+//************************************
+void ac_search_host(const ACAutomaton &ac, const char *text, size_t text_size,
+  std::vector<uint32_t> &counts)
+{
+  std::vector<uint32_t> hits(ac.num_states, 0);
+  uint32_t state = 0;
+  for (size_t i = 0; i < text_size; i++) {
+    uint32_t next = ac.delta[(size_t)state * ac.num_classes + ac.byte_class[(unsigned char)text[i]]];
+    state = next & AC_STATE_MASK;
+    if (next & AC_MATCH_FLAG)
+      hits[state]++;
+  }
+  ac_collect_counts(ac, hits, counts);
+}
+
+#endif
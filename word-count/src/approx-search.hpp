@@ -0,0 +1,232 @@
+//==============================================================
+// DPC++ Example
+//
+// Approximate keyword search for Word Count
+//
+// Counts the occurrences of each keyword within edit distance k
+// (insertions, deletions and substitutions) with Myers' bit-parallel
+// algorithm: the column of the edit distance matrix for a keyword of up to
+// 64 characters is kept as two 64-bit difference vectors, and each text
+// byte updates it with a handful of word operations.
+//
+// An occurrence is a maximal run of consecutive text positions at which
+// an approximate match of the keyword ends, so an exact match of "that"
+// with k = 1 (which also ends at "tha" and "that ") is counted once.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __APPROX_SEARCH_HPP__
+#define __APPROX_SEARCH_HPP__
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "word-count.hpp"
+
+// a keyword's column of the edit distance matrix must fit in one word
+constexpr size_t APPROX_MAX_KEYWORD_LEN = 64;
+
+struct ApproxKeywords {
+  std::vector<std::string> keywords;
+  uint32_t max_distance = 0;
+  // bytes that appear in no keyword share class 0 and match nothing
+  uint32_t num_classes = 0;
+  std::vector<uint8_t> byte_class;    // 256 entries
+  // peq[w * num_classes + c]: bit i is set if keyword w has a byte of class c at i
+  std::vector<uint64_t> peq;
+};
+
+//************************************
+// Build the match vectors of the keywords for edit distance max_distance
+//************************************
+ApproxKeywords build_approx_keywords(const std::vector<std::string> &keywords,
+  uint32_t max_distance)
+{
+  ApproxKeywords ak;
+  ak.keywords = keywords;
+  ak.max_distance = max_distance;
+  ak.byte_class.assign(256, 0);
+  ak.num_classes = 1;
+  for (auto &w : keywords) {
+    // a keyword no longer than the distance would match everywhere
+    if (w.size() > APPROX_MAX_KEYWORD_LEN || w.size() <= max_distance) {
+      std::cout << "Keyword " << w << " must be longer than the edit distance and at most "
+                << APPROX_MAX_KEYWORD_LEN << " characters" << std::endl;
+      exit(1);
+    }
+    for (unsigned char c : w)
+      if (ak.byte_class[c] == 0)
+        ak.byte_class[c] = ak.num_classes++;
+  }
+  if (ak.num_classes > 256) {
+    std::cout << "Too many distinct characters in the keywords" << std::endl;
+    exit(1);
+  }
+
+  ak.peq.assign(keywords.size() * ak.num_classes, 0);
+  for (size_t w = 0; w < keywords.size(); w++)
+    for (size_t i = 0; i < keywords[w].size(); i++)
+      ak.peq[w * ak.num_classes + ak.byte_class[(unsigned char)keywords[w][i]]] |= 1ull << i;
+  return ak;
+}
+
+//************************************
+// Approximate keyword count in DPC++ on device:
+//************************************
+// Each work-item owns chars_per_item end positions, laid out by global id,
+// and runs the keywords over its slice one after the other. Every match
+// within distance k ending at position j lies in the keyword_len + k - 1
+// bytes up to j, and deciding whether j starts a run needs the distance at
+// j - 1 as well, so a work-item starts keyword_len + k bytes before its
+// slice.
+void approx_search(queue &q, uint32_t n_wgroups, int wgroup_size, const ApproxKeywords &ak,
+  const char *text, size_t text_size, size_t chars_per_item, std::vector<uint32_t> &counts)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  uint32_t num_keywords = ak.keywords.size();
+  counts.assign(num_keywords, 0);
+  std::vector<uint32_t> lengths(num_keywords);
+  for (uint32_t w = 0; w < num_keywords; w++)
+    lengths[w] = ak.keywords[w].size();
+
+  auto local_mem_size = q.get_device().get_info<info::device::local_mem_size>();
+  if (local_mem_size < ak.peq.size() * sizeof(uint64_t) + 256)
+    throw "Device doesn't have enough local memory!";
+
+  {
+    buffer<char, 1> text_buf(text, range<1>(text_size));
+    buffer<uint8_t, 1> class_buf(ak.byte_class.data(), range<1>(256));
+    buffer<uint64_t, 1> peq_buf(ak.peq.data(), range<1>(ak.peq.size()));
+    buffer<uint32_t, 1> length_buf(lengths.data(), range<1>(num_keywords));
+    buffer<uint32_t, 1> count_buf(counts.data(), range<1>(num_keywords));
+
+    std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+    std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+    event e = q.submit([&] (handler& h) {
+      accessor <uint8_t, 1,
+        access::mode::read_write,
+        access::target::local>
+      local_class(range<1>(256), h);
+      accessor <uint64_t, 1,
+        access::mode::read_write,
+        access::target::local>
+      local_peq(range<1>(ak.peq.size()), h);
+
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto class_mem = class_buf.get_access<access::mode::read>(h);
+      auto peq_mem = peq_buf.get_access<access::mode::read>(h);
+      auto length_mem = length_buf.get_access<access::mode::read>(h);
+      auto count_mem = count_buf.get_access<access::mode::read_write>(h);
+
+      auto text_max_len = text_size;
+      auto num_classes = ak.num_classes;
+      auto num_peq = ak.peq.size();
+      uint32_t max_distance = ak.max_distance;
+
+      h.parallel_for<class myers_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t local_id = item.get_local_id(0);
+          for (size_t c = local_id; c < 256; c += wgroup_size)
+            local_class[c] = class_mem[c];
+          for (size_t p = local_id; p < num_peq; p += wgroup_size)
+            local_peq[p] = peq_mem[p];
+          item.barrier(sycl::access::fence_space::local_space);
+
+          size_t begin = item.get_global_id(0) * chars_per_item;
+          size_t end = begin + chars_per_item;
+          if (end > text_max_len)
+            end = text_max_len;
+
+          for (uint32_t w = 0; w < num_keywords; w++) {
+            uint32_t len = length_mem[w];
+            size_t halo = len + max_distance;
+            uint64_t high = 1ull << (len - 1);
+            // vertical +1/-1 differences of the column; the distance to the
+            // whole keyword (bottom cell) is tracked in score
+            uint64_t pv = ~0ull, mv = 0;
+            uint32_t score = len;
+            bool in_match = false;
+            uint32_t count = 0;
+            for (size_t i = (begin > halo ? begin - halo : 0); i < end; i++) {
+              uint64_t eq = local_peq[w * num_classes + local_class[(unsigned char)text_mem[i]]];
+              uint64_t xv = eq | mv;
+              uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+              uint64_t ph = mv | ~(xh | pv);
+              uint64_t mh = pv & xh;
+              if (ph & high)
+                score++;
+              else if (mh & high)
+                score--;
+              // the top row stays 0: a match may start anywhere in the text
+              ph <<= 1;
+              mh <<= 1;
+              pv = mh | ~(xv | ph);
+              mv = ph & xv;
+
+              bool match = score <= max_distance;
+              if (match && !in_match && i >= begin)
+                count++;
+              in_match = match;
+            }
+            uint32_t group_count = reduce_over_group(item.get_group(), count, sycl::plus<uint32_t>());
+            if (local_id == 0 && group_count != 0)
+              global_atomic_ref<uint32_t>(count_mem[w]) += group_count;
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    total_kernel_time_ns += kernel_time_ns;
+
+    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // buffers copy the counts back to host here
+}
+
+//************************************
+// Approximate keyword count on host with the edit distance matrix (Sellers'
+// algorithm), used to validate the device results
+//************************************
+void approx_search_host(const ApproxKeywords &ak, const char *text, size_t text_size,
+  std::vector<uint32_t> &counts)
+{
+  counts.assign(ak.keywords.size(), 0);
+  for (size_t w = 0; w < ak.keywords.size(); w++) {
+    const std::string &key = ak.keywords[w];
+    size_t m = key.size();
+    // column j of the matrix: distance from key[0..i) to the best substring ending at j
+    std::vector<uint32_t> col(m + 1), prev(m + 1);
+    for (size_t i = 0; i <= m; i++)
+      col[i] = i;
+    bool in_match = false;
+    for (size_t j = 0; j < text_size; j++) {
+      prev.swap(col);
+      col[0] = 0;
+      for (size_t i = 1; i <= m; i++)
+        col[i] = std::min({prev[i] + 1, col[i-1] + 1,
+                           prev[i-1] + (key[i-1] == text[j] ? 0u : 1u)});
+      bool match = col[m] <= ak.max_distance;
+      if (match && !in_match)
+        counts[w]++;
+      in_match = match;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,223 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: host and device counting together
+//
+// The text is cut into chunks that the device and the host SIMD matcher
+// threads count side by side. Every worker owns a contiguous range of
+// chunks and takes them from its front; a worker that runs dry steals the
+// back half of the largest range left, so the faster engine ends up with
+// the larger share and both finish at about the same time.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __COOP_SEARCH_HPP__
+#define __COOP_SEARCH_HPP__
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "word-count.hpp"
+#include "host-search.hpp"
+#include "string-search.hpp"
+
+// contiguous chunks the device takes from its own range per kernel launch
+constexpr size_t DEVICE_BATCH_CHUNKS = 4;
+
+// the chunks [next, end) still owned by one worker
+struct ChunkRange {
+  std::mutex lock;
+  size_t next = 0;
+  size_t end = 0;
+};
+
+struct WorkerStats {
+  size_t bytes = 0;
+  size_t chunks = 0;
+  size_t steals = 0;
+};
+
+//************************************
+// Take up to max_chunks chunks for worker w, stealing if its range is
+// empty; returns false once no chunk is left anywhere
+//************************************
+bool take_chunks(std::vector<ChunkRange> &ranges, size_t w, size_t max_chunks,
+  size_t &first, size_t &last, WorkerStats &stats)
+{
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> guard(ranges[w].lock);
+      if (ranges[w].next < ranges[w].end) {
+        first = ranges[w].next;
+        last = std::min(ranges[w].end, first + max_chunks);
+        ranges[w].next = last;
+        return true;
+      }
+    }
+
+    // the victim is the worker with the most chunks left
+    size_t victim = w, most = 0;
+    for (size_t v = 0; v < ranges.size(); v++) {
+      std::lock_guard<std::mutex> guard(ranges[v].lock);
+      if (ranges[v].end - ranges[v].next > most) {
+        most = ranges[v].end - ranges[v].next;
+        victim = v;
+      }
+    }
+    if (most == 0)
+      return false;
+
+    size_t stolen_first, stolen_last;
+    {
+      std::lock_guard<std::mutex> guard(ranges[victim].lock);
+      size_t left = ranges[victim].end - ranges[victim].next;
+      if (left == 0)
+        continue;   // someone else got there first
+      stolen_last = ranges[victim].end;
+      stolen_first = stolen_last - (left + 1) / 2;
+      ranges[victim].end = stolen_first;
+    }
+    std::lock_guard<std::mutex> guard(ranges[w].lock);
+    ranges[w].next = stolen_first;
+    ranges[w].end = stolen_last;
+    stats.steals++;
+  }
+}
+
+//************************************
+// Word Count on device and host together:
+//************************************
+// A chunk counts the keywords *starting* in it and reads up to
+// KEYWORD_LEN-1 bytes past its end, so no keyword is lost or counted twice
+// at chunk boundaries, whoever counts the neighbouring chunk. One host
+// thread is left to drive the device.
+void coop_search(queue &q, uint32_t n_wgroups, int wgroup_size,
+  const std::vector<char4> &pattern, const char *text, size_t text_size,
+  size_t chunk_size, uint32_t *global_result, Partition partition = CONTIGUOUS)
+{
+  if (text_size < KEYWORD_LEN)
+    return;
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  char keywords[NUM_KEYWORDS][KEYWORD_LEN];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    for (int j = 0; j < KEYWORD_LEN; j++)
+      keywords[k][j] = pattern[k][j];
+  const char *isa;
+  count_range_fn count_range = select_count_range(&isa);
+
+  size_t num_windows = text_size - KEYWORD_LEN + 1;
+  size_t num_chunks = (num_windows + chunk_size - 1) / chunk_size;
+  size_t num_host_threads = std::max<size_t>(1, std::thread::hardware_concurrency()) - 1;
+  num_host_threads = std::max<size_t>(1, num_host_threads);
+  size_t num_workers = num_host_threads + 1;   // worker 0 is the device
+
+  // start from equal shares, stealing evens out the rest
+  std::vector<ChunkRange> ranges(num_workers);
+  for (size_t w = 0; w < num_workers; w++) {
+    ranges[w].next = num_chunks * w / num_workers;
+    ranges[w].end = num_chunks * (w + 1) / num_workers;
+  }
+  std::vector<WorkerStats> stats(num_workers);
+  std::vector<double> busy_s(num_workers, 0);
+  std::vector<std::array<uint32_t, NUM_KEYWORDS>> worker_result(num_workers);
+  for (auto &r : worker_result)
+    r.fill(0);
+
+  size_t total_num_workitems = (size_t)n_wgroups * wgroup_size;
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+  std::cout << "chunk_size = " << chunk_size << " bytes, chunks = " << num_chunks
+            << ", host threads = " << num_host_threads << " (" << isa << ")" << std::endl;
+
+  dpc_common::TimeInterval coop_time;
+  std::exception_ptr device_error;
+  std::vector<std::thread> workers;
+  workers.emplace_back([&] {
+    try {
+      dpc_common::TimeInterval device_time;
+      buffer<uint32_t,1> group_result_buf{range<1>(n_wgroups * NUM_KEYWORDS)};
+      size_t first, last;
+      while (take_chunks(ranges, 0, DEVICE_BATCH_CHUNKS, first, last, stats[0])) {
+        size_t begin = first * chunk_size;
+        size_t end = std::min(num_windows, last * chunk_size);
+        // the windows starting in [begin, end) and the bytes they cover
+        size_t span_len = end - begin + KEYWORD_LEN - 1;
+        uint32_t batch_result[NUM_KEYWORDS] = {0, 0, 0, 0};
+        {
+          buffer<char,1> text_buf(text + begin, range<1>(span_len));
+          buffer<uint32_t,1> result_buf(batch_result, range<1>(NUM_KEYWORDS));
+          size_t chars_per_item = (span_len + total_num_workitems - 1) / total_num_workitems;
+          SearchEvents e = submit_string_search(q, text_buf, span_len, n_wgroups, wgroup_size,
+            pattern, chars_per_item, group_result_buf, result_buf, partition);
+#if FPGA || FPGA_PROFILE
+          total_kernel_time_ns += kernel_time_ns(e);
+#endif
+        } // result_buf copies the batch's counters back here
+        for (int k = 0; k < NUM_KEYWORDS; k++)
+          worker_result[0][k] += batch_result[k];
+        stats[0].bytes += end - begin;
+        stats[0].chunks += last - first;
+      }
+      busy_s[0] = device_time.Elapsed();
+    } catch (...) {
+      // the host threads steal what is left of the device's range
+      device_error = std::current_exception();
+    }
+  });
+  for (size_t w = 1; w < num_workers; w++) {
+    workers.emplace_back([&, w] {
+      dpc_common::TimeInterval host_time;
+      size_t first, last;
+      while (take_chunks(ranges, w, 1, first, last, stats[w])) {
+        size_t begin = first * chunk_size;
+        size_t end = std::min(num_windows, last * chunk_size);
+        count_range(keywords, text, begin, end, worker_result[w].data());
+        stats[w].bytes += end - begin;
+        stats[w].chunks += last - first;
+      }
+      busy_s[w] = host_time.Elapsed();
+    });
+  }
+  for (auto &t : workers)
+    t.join();
+  if (device_error)
+    std::rethrow_exception(device_error);
+  double coop_time_s = coop_time.Elapsed();
+
+  for (size_t w = 0; w < num_workers; w++)
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      global_result[k] += worker_result[w][k];
+
+  WorkerStats host;
+  double host_busy_s = 0;
+  for (size_t w = 1; w < num_workers; w++) {
+    host.bytes += stats[w].bytes;
+    host.chunks += stats[w].chunks;
+    host.steals += stats[w].steals;
+    host_busy_s = std::max(host_busy_s, busy_s[w]);
+  }
+  auto rate = [](size_t bytes, double s) { return s > 0 ? bytes / s * 1e-9 : 0; };
+  std::cout << "device: " << stats[0].chunks << " chunks, " << stats[0].steals << " steals, "
+            << rate(stats[0].bytes, busy_s[0]) << " GB/s\n";
+  std::cout << "host:   " << host.chunks << " chunks, " << host.steals << " steals, "
+            << rate(host.bytes, host_busy_s) << " GB/s\n";
+  std::cout << "cooperative search: " << coop_time_s * 1000 << " ms ("
+            << text_size / coop_time_s * 1e-9 << " GB/s, " << partition_name(partition)
+            << " partitioning)\n";
+#if FPGA || FPGA_PROFILE
+  std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+}
+
+#endif
@@ -0,0 +1,286 @@
+//==============================================================
+// DPC++ Example
+//
+// Multi-document corpus statistics for Word Count
+//
+// Many small files are packed back to back into one buffer, with an
+// offsets array marking where each document starts, so that the whole
+// corpus is transferred once and scanned by a single kernel launch instead
+// of one launch per file. The kernel produces the term frequency of every
+// built-in keyword in every document together with the document frequency
+// of each keyword over the corpus, from which TF-IDF is derived on host.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __CORPUS_HPP__
+#define __CORPUS_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "word-count.hpp"
+#include "host-search.hpp"
+
+struct Corpus {
+  std::vector<std::string> paths;
+  // document d is text[offsets[d] .. offsets[d+1])
+  std::vector<uint64_t> offsets;
+  std::vector<char> text;
+};
+
+struct CorpusStats {
+  uint32_t num_docs = 0;
+  // tf[d * NUM_KEYWORDS + k]: occurrences of keyword k in document d
+  std::vector<uint32_t> tf;
+  // df[k]: documents containing keyword k
+  uint32_t df[NUM_KEYWORDS] = {0, 0, 0, 0};
+};
+
+// run fn(i) for i in [0, n) on all hardware threads
+template <typename Fn>
+void parallel_for_files(size_t n, Fn fn) {
+  size_t num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, std::max<size_t>(1, n));
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < num_threads; t++)
+    readers.emplace_back([&] {
+      for (size_t i = next++; i < n; i = next++)
+        fn(i);
+    });
+  for (auto &r : readers)
+    r.join();
+}
+
+//************************************
+// Load the corpus: every regular file below a directory, or the files
+// listed one per line in a list file
+//************************************
+// The sizes are taken first to lay out the packed buffer, then the files
+// are read straight into their place by parallel readers.
+void load_corpus(const char *corpus_path, Corpus &corpus) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  if (fs::is_directory(corpus_path, ec)) {
+    for (auto &entry : fs::recursive_directory_iterator(corpus_path, ec))
+      if (entry.is_regular_file())
+        corpus.paths.push_back(entry.path().string());
+    std::sort(corpus.paths.begin(), corpus.paths.end());
+  } else {
+    FILE *list_handle = fopen(corpus_path, "r");
+    if (list_handle == NULL) {
+      perror("Couldn't find the corpus");
+      exit(1);
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), list_handle) != NULL) {
+      size_t len = strcspn(line, "\r\n");
+      if (len != 0)
+        corpus.paths.push_back(std::string(line, len));
+    }
+    fclose(list_handle);
+  }
+  if (corpus.paths.empty() || corpus.paths.size() >= UINT32_MAX) {
+    std::cout << "No documents found in " << corpus_path << std::endl;
+    exit(1);
+  }
+
+  size_t num_docs = corpus.paths.size();
+  std::vector<uint64_t> sizes(num_docs);
+  parallel_for_files(num_docs, [&](size_t d) {
+    std::error_code size_ec;
+    sizes[d] = fs::file_size(corpus.paths[d], size_ec);
+    if (size_ec) {
+      std::cout << "Couldn't find " << corpus.paths[d] << std::endl;
+      exit(1);
+    }
+  });
+  corpus.offsets.resize(num_docs + 1);
+  corpus.offsets[0] = 0;
+  for (size_t d = 0; d < num_docs; d++)
+    corpus.offsets[d + 1] = corpus.offsets[d] + sizes[d];
+
+  corpus.text.resize(corpus.offsets[num_docs]);
+  parallel_for_files(num_docs, [&](size_t d) {
+    FILE *doc_handle = fopen(corpus.paths[d].c_str(), "rb");
+    if (doc_handle == NULL ||
+        fread(corpus.text.data() + corpus.offsets[d], sizeof(char), sizes[d], doc_handle) != sizes[d]) {
+      perror(corpus.paths[d].c_str());
+      exit(1);
+    }
+    fclose(doc_handle);
+  });
+}
+
+//************************************
+// Per-document keyword counts in DPC++ on device:
+//************************************
+// Work-items get slices of the packed text as usual and find the document
+// of their first position by binary search in the offsets. A keyword must
+// end inside the document it starts in. Counts are kept in registers while
+// a work-item stays in one document and added to the global table when it
+// moves on; the one add that takes a count from 0 also adds the document
+// to the keyword's document frequency, so df is exact without a second
+// pass. Only the documents at the ends of a slice are shared with other
+// work-items, so the atomics are few.
+void corpus_search(queue &q, uint32_t n_wgroups, int wgroup_size,
+  const std::vector<char4> &pattern, const Corpus &corpus, size_t chars_per_item,
+  CorpusStats &stats)
+{
+  char4 keywords[NUM_KEYWORDS];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    keywords[k] = pattern[k];
+  uint32_t num_docs = corpus.paths.size();
+  size_t text_size = corpus.text.size();
+  stats.num_docs = num_docs;
+  stats.tf.assign((size_t)num_docs * NUM_KEYWORDS, 0);
+  std::fill(stats.df, stats.df + NUM_KEYWORDS, 0);
+  if (text_size == 0)
+    return;
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  {
+    buffer<char,1> text_buf(corpus.text.data(), range<1>(text_size));
+    buffer<uint64_t,1> offset_buf(corpus.offsets.data(), range<1>(num_docs + 1));
+    buffer<uint32_t,1> tf_buf(stats.tf.data(), range<1>(stats.tf.size()));
+    buffer<uint32_t,1> df_buf(stats.df, range<1>(NUM_KEYWORDS));
+
+    event e = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto offsets = offset_buf.get_access<access::mode::read>(h);
+      auto tf = tf_buf.get_access<access::mode::read_write>(h);
+      auto df = df_buf.get_access<access::mode::read_write>(h);
+      auto text_max_len = text_size;
+
+      h.parallel_for<class corpus_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t begin = item.get_global_id(0) * chars_per_item;
+          size_t end = std::min(text_max_len, begin + chars_per_item);
+          if (begin >= end)
+            return;
+
+          // the last document starting at or before begin
+          uint32_t lo = 0, hi = num_docs;
+          while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (offsets[mid] <= begin)
+              lo = mid;
+            else
+              hi = mid;
+          }
+          uint32_t doc = lo;
+          uint64_t doc_end = offsets[doc + 1];
+
+          uint32_t count[NUM_KEYWORDS] = {0, 0, 0, 0};
+          auto flush = [&]() {
+            for (int k = 0; k < NUM_KEYWORDS; k++)
+              if (count[k] != 0) {
+                if (global_atomic_ref<uint32_t>(tf[(size_t)doc * NUM_KEYWORDS + k])
+                      .fetch_add(count[k]) == 0)
+                  global_atomic_ref<uint32_t>(df[k])++;
+                count[k] = 0;
+              }
+          };
+
+          for (size_t i = begin; i < end; i++) {
+            while (i >= doc_end) {
+              flush();
+              doc++;
+              doc_end = offsets[doc + 1];
+            }
+            if (i + KEYWORD_LEN > doc_end)
+              continue;
+            char4 text_word;
+            text_word.load(0, text_mem.get_pointer()+i);
+            for (int k = 0; k < NUM_KEYWORDS; k++)
+              if (text_word.x() == keywords[k].x() &&
+                  text_word.y() == keywords[k].y() &&
+                  text_word.z() == keywords[k].z() &&
+                  text_word.w() == keywords[k].w())
+                count[k]++;
+          }
+          flush();
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+    std::cout << " Total Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // buffers copy tf and df back to host here
+}
+
+// idf = log(N / df); a keyword found in no document gets 0
+inline double inverse_document_frequency(const CorpusStats &stats, int k) {
+  return stats.df[k] == 0 ? 0 : std::log((double)stats.num_docs / stats.df[k]);
+}
+
+//************************************
+// Write the TF-IDF table: one line per document and keyword it contains
+//************************************
+void write_tfidf(const char *path, const std::vector<char4> &pattern, const Corpus &corpus,
+  const CorpusStats &stats)
+{
+  FILE *tfidf_handle = fopen(path, "w");
+  if (tfidf_handle == NULL) {
+    perror("Couldn't create the TF-IDF file");
+    exit(1);
+  }
+  fprintf(tfidf_handle, "document\tkeyword\ttf\ttf-idf\n");
+  for (uint32_t d = 0; d < stats.num_docs; d++)
+    for (int k = 0; k < NUM_KEYWORDS; k++) {
+      uint32_t tf = stats.tf[(size_t)d * NUM_KEYWORDS + k];
+      if (tf != 0)
+        fprintf(tfidf_handle, "%s\t%c%c%c%c\t%u\t%.6f\n", corpus.paths[d].c_str(),
+                pattern[k][0], pattern[k][1], pattern[k][2], pattern[k][3], tf,
+                tf * inverse_document_frequency(stats, k));
+    }
+  fclose(tfidf_handle);
+}
+
+//************************************
+// Per-document keyword counts on host, used to validate the device results
+//************************************
+void corpus_search_host(const std::vector<char4> &pattern, const Corpus &corpus,
+  CorpusStats &stats)
+{
+  char keywords[NUM_KEYWORDS][KEYWORD_LEN];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    for (int j = 0; j < KEYWORD_LEN; j++)
+      keywords[k][j] = pattern[k][j];
+  const char *isa;
+  count_range_fn count_range = select_count_range(&isa);
+
+  uint32_t num_docs = corpus.paths.size();
+  stats.num_docs = num_docs;
+  stats.tf.assign((size_t)num_docs * NUM_KEYWORDS, 0);
+  std::fill(stats.df, stats.df + NUM_KEYWORDS, 0);
+  parallel_for_files(num_docs, [&](size_t d) {
+    uint64_t len = corpus.offsets[d + 1] - corpus.offsets[d];
+    if (len >= KEYWORD_LEN)
+      count_range(keywords, corpus.text.data() + corpus.offsets[d], 0, len - KEYWORD_LEN + 1,
+                  stats.tf.data() + d * NUM_KEYWORDS);
+  });
+  for (uint32_t d = 0; d < num_docs; d++)
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      if (stats.tf[(size_t)d * NUM_KEYWORDS + k] != 0)
+        stats.df[k]++;
+}
+
+#endif
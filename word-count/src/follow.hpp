@@ -0,0 +1,257 @@
+//==============================================================
+// DPC++ Example
+//
+// Incremental keyword counting for growing files (tail -f)
+//
+// A log that grows all day is counted incrementally: only the bytes
+// appended since the last pass go through the search kernels, prefixed
+// with the last KEYWORD_LEN-1 bytes already seen (the tail) so a keyword
+// written across two appends is counted once. The offset, the tail and
+// the running totals are saved next to the file, so a restarted follower
+// resumes where it stopped. Optionally, the counts of the last N bytes or
+// the last N seconds are kept in a ring of per-bucket counters.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __FOLLOW_HPP__
+#define __FOLLOW_HPP__
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "word-count.hpp"
+#include "string-search.hpp"
+
+// the follower state is saved to the file's name with this suffix
+#define FOLLOW_STATE_EXT ".follow"
+// how often the file is checked for new bytes
+constexpr int FOLLOW_POLL_MS = 1000;
+// appended bytes are read and counted in pieces of at most this size
+constexpr size_t FOLLOW_MAX_PIECE = 64 << 20;
+// buckets of the sliding window ring; the window moves one bucket at a time
+constexpr size_t WINDOW_BUCKETS = 60;
+
+struct FollowState {
+  char magic[4];
+  uint32_t tail_len;
+  uint64_t offset;                  // bytes of the file counted so far
+  char tail[KEYWORD_LEN - 1];       // the last tail_len of them
+  uint64_t totals[NUM_KEYWORDS];
+};
+constexpr char FOLLOW_STATE_MAGIC[4] = {'W', 'C', 'F', 'S'};
+
+enum WindowUnit { WINDOW_NONE, WINDOW_BYTES, WINDOW_SECONDS };
+
+// counts of the last WINDOW_BUCKETS buckets of span bytes or seconds
+struct WindowRing {
+  WindowUnit unit = WINDOW_NONE;
+  uint64_t span = 0;
+  std::vector<uint64_t> bucket;     // the bucket number held by each slot
+  std::vector<std::array<uint64_t, NUM_KEYWORDS>> counts;
+};
+
+//************************************
+// Parse a window size: a byte count with an optional K/M/G suffix, or a
+// duration ending in s, min or h
+//************************************
+WindowRing parse_window(const char *arg) {
+  WindowRing ring;
+  char *end;
+  uint64_t n = strtoull(arg, &end, 10);
+  if (strcmp(end, "s") == 0)
+    ring.unit = WINDOW_SECONDS;
+  else if (strcmp(end, "min") == 0) {
+    ring.unit = WINDOW_SECONDS;
+    n *= 60;
+  } else if (strcmp(end, "h") == 0) {
+    ring.unit = WINDOW_SECONDS;
+    n *= 3600;
+  } else {
+    ring.unit = WINDOW_BYTES;
+    n = parse_size(arg);
+  }
+  if (n < WINDOW_BUCKETS) {
+    std::cout << "The window (-w) must span at least " << WINDOW_BUCKETS
+              << " bytes or seconds" << std::endl;
+    exit(1);
+  }
+  ring.span = n / WINDOW_BUCKETS;
+  ring.bucket.assign(WINDOW_BUCKETS, UINT64_MAX);
+  ring.counts.resize(WINDOW_BUCKETS);
+  return ring;
+}
+
+void window_add(WindowRing &ring, uint64_t bucket, const uint32_t *counts) {
+  size_t slot = bucket % WINDOW_BUCKETS;
+  if (ring.bucket[slot] != bucket) {
+    ring.bucket[slot] = bucket;
+    ring.counts[slot].fill(0);
+  }
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    ring.counts[slot][k] += counts[k];
+}
+
+// the counts of the buckets current - WINDOW_BUCKETS + 1 .. current
+void window_sum(const WindowRing &ring, uint64_t current, uint64_t *sum) {
+  std::fill(sum, sum + NUM_KEYWORDS, 0);
+  for (size_t slot = 0; slot < WINDOW_BUCKETS; slot++)
+    if (ring.bucket[slot] <= current && ring.bucket[slot] + WINDOW_BUCKETS > current)
+      for (int k = 0; k < NUM_KEYWORDS; k++)
+        sum[k] += ring.counts[slot][k];
+}
+
+inline uint64_t seconds_now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//************************************
+// Load the saved state, or start from the beginning of the file if there
+// is none or the file was truncated or rewritten since
+//************************************
+FollowState load_follow_state(const std::string &state_path, FILE *text_handle,
+  uint64_t file_size)
+{
+  FollowState state;
+  FILE *state_handle = fopen(state_path.c_str(), "rb");
+  bool valid = state_handle != NULL &&
+    fread(&state, sizeof(state), 1, state_handle) == 1 &&
+    memcmp(state.magic, FOLLOW_STATE_MAGIC, sizeof(state.magic)) == 0 &&
+    state.tail_len <= KEYWORD_LEN - 1 && state.offset >= state.tail_len &&
+    state.offset <= file_size;
+  if (state_handle != NULL)
+    fclose(state_handle);
+  if (valid) {
+    // the bytes before the offset must still be the ones counted
+    char tail[KEYWORD_LEN - 1];
+    fseek(text_handle, state.offset - state.tail_len, SEEK_SET);
+    valid = fread(tail, 1, state.tail_len, text_handle) == state.tail_len &&
+            memcmp(tail, state.tail, state.tail_len) == 0;
+  }
+  if (!valid) {
+    memset(&state, 0, sizeof(state));
+    memcpy(state.magic, FOLLOW_STATE_MAGIC, sizeof(state.magic));
+  }
+  return state;
+}
+
+void save_follow_state(const std::string &state_path, const FollowState &state) {
+  FILE *state_handle = fopen(state_path.c_str(), "wb");
+  if (state_handle == NULL || fwrite(&state, sizeof(state), 1, state_handle) != 1) {
+    perror("Couldn't write the follow state file");
+    exit(1);
+  }
+  fclose(state_handle);
+}
+
+//************************************
+// Follow a growing file, counting the appended bytes in DPC++ on device:
+//************************************
+// Every poll reads the bytes appended since the saved offset, piece by
+// piece, and counts each piece with the string_search kernels. In byte
+// window mode the pieces are also cut at bucket boundaries, so every
+// piece's counts land in the bucket holding its first byte.
+void follow_search(queue &q, uint32_t n_wgroups, int wgroup_size,
+  const std::vector<char4> &pattern, const char *text_file, WindowRing &ring,
+  Partition partition = CONTIGUOUS)
+{
+  constexpr size_t halo = KEYWORD_LEN - 1;
+  std::string state_path = std::string(text_file) + FOLLOW_STATE_EXT;
+  size_t total_num_workitems = (size_t)n_wgroups * wgroup_size;
+  std::vector<char> piece(halo + FOLLOW_MAX_PIECE);
+  buffer<uint32_t,1> group_result_buf{range<1>(n_wgroups * NUM_KEYWORDS)};
+
+  FILE *text_handle = fopen(text_file, "rb");
+  if (text_handle == NULL) {
+    perror("Couldn't find the text file");
+    exit(1);
+  }
+  fseek(text_handle, 0, SEEK_END);
+  FollowState state = load_follow_state(state_path, text_handle, ftell(text_handle));
+  std::cout << std::endl << "following " << text_file << " from offset " << state.offset
+            << " (state in " << state_path << ")" << std::endl;
+
+  for (;;) {
+    fseek(text_handle, 0, SEEK_END);
+    uint64_t file_size = ftell(text_handle);
+    if (file_size < state.offset) {
+      std::cout << text_file << " was truncated, starting over" << std::endl;
+      memset(&state, 0, sizeof(state));
+      memcpy(state.magic, FOLLOW_STATE_MAGIC, sizeof(state.magic));
+    }
+    if (file_size == state.offset) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MS));
+      continue;
+    }
+
+    dpc_common::TimeInterval update_time;
+    uint64_t update_begin = state.offset;
+    uint32_t update_result[NUM_KEYWORDS] = {0, 0, 0, 0};
+    fseek(text_handle, state.offset, SEEK_SET);
+    while (state.offset < file_size) {
+      size_t want = std::min<uint64_t>(FOLLOW_MAX_PIECE, file_size - state.offset);
+      if (ring.unit == WINDOW_BYTES)
+        want = std::min<uint64_t>(want, ring.span - state.offset % ring.span);
+      char *chunk = piece.data();
+      memcpy(chunk, state.tail, state.tail_len);
+      if (fread(chunk + state.tail_len, 1, want, text_handle) != want) {
+        perror("Couldn't read the text file");
+        exit(1);
+      }
+      size_t chunk_len = state.tail_len + want;
+
+      uint32_t piece_result[NUM_KEYWORDS] = {0, 0, 0, 0};
+      if (chunk_len >= KEYWORD_LEN) {
+        buffer<char,1> text_buf(chunk, range<1>(chunk_len));
+        buffer<uint32_t,1> result_buf(piece_result, range<1>(NUM_KEYWORDS));
+        size_t chars_per_item = (chunk_len + total_num_workitems - 1) / total_num_workitems;
+        submit_string_search(q, text_buf, chunk_len, n_wgroups, wgroup_size, pattern,
+          chars_per_item, group_result_buf, result_buf, partition);
+      } // result_buf copies the piece's counters back here
+      if (ring.unit == WINDOW_BYTES)
+        window_add(ring, state.offset / ring.span, piece_result);
+      else if (ring.unit == WINDOW_SECONDS)
+        window_add(ring, seconds_now() / ring.span, piece_result);
+      for (int k = 0; k < NUM_KEYWORDS; k++) {
+        update_result[k] += piece_result[k];
+        state.totals[k] += piece_result[k];
+      }
+
+      // the last bytes of this piece become the tail of the next one
+      state.offset += want;
+      size_t carry = std::min(halo, chunk_len);
+      memmove(state.tail, chunk + chunk_len - carry, carry);
+      state.tail_len = carry;
+    }
+    save_follow_state(state_path, state);
+
+    double update_time_s = update_time.Elapsed();
+    std::cout << "+" << state.offset - update_begin << " bytes at offset " << update_begin
+              << " in " << update_time_s * 1000 << " ms:";
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      std::cout << " " << pattern[k][0] << pattern[k][1] << pattern[k][2] << pattern[k][3]
+                << " +" << update_result[k] << " = " << state.totals[k];
+    std::cout << std::endl;
+    if (ring.unit != WINDOW_NONE) {
+      uint64_t window[NUM_KEYWORDS];
+      window_sum(ring, ring.unit == WINDOW_BYTES ? (state.offset - 1) / ring.span
+                                                 : seconds_now() / ring.span, window);
+      std::cout << "  last " << ring.span * WINDOW_BUCKETS
+                << (ring.unit == WINDOW_BYTES ? " bytes:" : " seconds:");
+      for (int k = 0; k < NUM_KEYWORDS; k++)
+        std::cout << " " << pattern[k][0] << pattern[k][1] << pattern[k][2] << pattern[k][3]
+                  << " " << window[k];
+      std::cout << std::endl;
+    }
+  }
+}
+
+#endif
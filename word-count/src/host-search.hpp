@@ -0,0 +1,174 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: multithreaded SIMD keyword count on host
+//
+// The host reference splits the text across all hardware threads. Each
+// thread compares 32 (AVX2) or 64 (AVX-512BW) four-byte windows per step:
+// the four bytes of every window come from four unaligned loads shifted by
+// one byte, each compared against one keyword byte broadcast to all lanes.
+// The AND of the four compare masks has one bit per matching window, which
+// is counted with popcount. The instruction set is picked at run time, so
+// the binary needs no -march flags and still runs on older CPUs.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __HOST_SEARCH_HPP__
+#define __HOST_SEARCH_HPP__
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "word-count.hpp"
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__)) \
+    && !defined(__SYCL_DEVICE_ONLY__)
+#define HOST_SEARCH_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// inputs smaller than this per thread are not worth another thread
+constexpr size_t HOST_BYTES_PER_THREAD = 1 << 20;
+
+// count the keywords starting at positions [begin, end) of text; end must
+// not exceed text_size-KEYWORD_LEN+1
+typedef void (*count_range_fn)(const char (*keywords)[KEYWORD_LEN], const char *text,
+  size_t begin, size_t end, uint32_t *counts);
+
+void count_range_scalar(const char (*keywords)[KEYWORD_LEN], const char *text,
+  size_t begin, size_t end, uint32_t *counts)
+{
+  for (size_t i = begin; i < end; i++)
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      if (text[i] == keywords[k][0] &&
+          text[i+1] == keywords[k][1] &&
+          text[i+2] == keywords[k][2] &&
+          text[i+3] == keywords[k][3])
+        counts[k]++;
+}
+
+#ifdef HOST_SEARCH_X86_SIMD
+__attribute__((target("avx2,popcnt")))
+void count_range_avx2(const char (*keywords)[KEYWORD_LEN], const char *text,
+  size_t begin, size_t end, uint32_t *counts)
+{
+  __m256i key[NUM_KEYWORDS][KEYWORD_LEN];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    for (int j = 0; j < KEYWORD_LEN; j++)
+      key[k][j] = _mm256_set1_epi8(keywords[k][j]);
+
+  size_t i = begin;
+  // the last load of a step reads up to text[i+31+KEYWORD_LEN-1], which
+  // is in bounds as long as i+31 is a valid window start
+  for (; i + 32 <= end; i += 32) {
+    __m256i b0 = _mm256_loadu_si256((const __m256i *)(text + i));
+    __m256i b1 = _mm256_loadu_si256((const __m256i *)(text + i + 1));
+    __m256i b2 = _mm256_loadu_si256((const __m256i *)(text + i + 2));
+    __m256i b3 = _mm256_loadu_si256((const __m256i *)(text + i + 3));
+    for (int k = 0; k < NUM_KEYWORDS; k++) {
+      __m256i m = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi8(b0, key[k][0]), _mm256_cmpeq_epi8(b1, key[k][1])),
+        _mm256_and_si256(_mm256_cmpeq_epi8(b2, key[k][2]), _mm256_cmpeq_epi8(b3, key[k][3])));
+      counts[k] += __builtin_popcount((unsigned)_mm256_movemask_epi8(m));
+    }
+  }
+  count_range_scalar(keywords, text, i, end, counts);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+void count_range_avx512(const char (*keywords)[KEYWORD_LEN], const char *text,
+  size_t begin, size_t end, uint32_t *counts)
+{
+  __m512i key[NUM_KEYWORDS][KEYWORD_LEN];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    for (int j = 0; j < KEYWORD_LEN; j++)
+      key[k][j] = _mm512_set1_epi8(keywords[k][j]);
+
+  size_t i = begin;
+  for (; i + 64 <= end; i += 64) {
+    __m512i b0 = _mm512_loadu_si512((const void *)(text + i));
+    __m512i b1 = _mm512_loadu_si512((const void *)(text + i + 1));
+    __m512i b2 = _mm512_loadu_si512((const void *)(text + i + 2));
+    __m512i b3 = _mm512_loadu_si512((const void *)(text + i + 3));
+    for (int k = 0; k < NUM_KEYWORDS; k++) {
+      __mmask64 m = _mm512_cmpeq_epi8_mask(b0, key[k][0]) &
+                    _mm512_cmpeq_epi8_mask(b1, key[k][1]) &
+                    _mm512_cmpeq_epi8_mask(b2, key[k][2]) &
+                    _mm512_cmpeq_epi8_mask(b3, key[k][3]);
+      counts[k] += __builtin_popcountll(m);
+    }
+  }
+  count_range_scalar(keywords, text, i, end, counts);
+}
+#endif
+
+// the widest matcher this CPU supports
+count_range_fn select_count_range(const char **name) {
+#ifdef HOST_SEARCH_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512bw")) {
+    *name = "AVX-512BW";
+    return count_range_avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    *name = "AVX2";
+    return count_range_avx2;
+  }
+#endif
+  *name = "scalar";
+  return count_range_scalar;
+}
+
+//************************************
+// Word Count on host, used to validate the device results
+//************************************
+void count_keywords_host(const std::vector<char4> &pattern, const char *text,
+  size_t text_size, uint32_t *host_result, bool verbose = false)
+{
+  if (text_size < KEYWORD_LEN)
+    return;
+
+  char keywords[NUM_KEYWORDS][KEYWORD_LEN];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    for (int j = 0; j < KEYWORD_LEN; j++)
+      keywords[k][j] = pattern[k][j];
+
+  const char *isa;
+  count_range_fn count_range = select_count_range(&isa);
+
+  // every position up to text_size-KEYWORD_LEN starts a window
+  size_t num_windows = text_size - KEYWORD_LEN + 1;
+  size_t num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  num_threads = std::min(num_threads, std::max<size_t>(1, num_windows / HOST_BYTES_PER_THREAD));
+  // keep thread boundaries on 64-byte multiples so only the last thread
+  // runs a scalar tail
+  size_t per_thread = (num_windows + num_threads - 1) / num_threads;
+  per_thread = (per_thread + 63) / 64 * 64;
+
+  std::vector<std::array<uint32_t, NUM_KEYWORDS>> thread_result(num_threads);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < num_threads; t++) {
+    thread_result[t].fill(0);
+    size_t begin = std::min(num_windows, t * per_thread);
+    size_t end = std::min(num_windows, begin + per_thread);
+    workers.emplace_back([&, t, begin, end] {
+      count_range(keywords, text, begin, end, thread_result[t].data());
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  for (size_t t = 0; t < num_threads; t++)
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      host_result[k] += thread_result[t][k];
+
+  if (verbose)
+    std::cout << "host matcher: " << isa << ", " << num_threads << " threads" << std::endl;
+}
+
+#endif
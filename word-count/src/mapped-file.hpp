@@ -0,0 +1,72 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: read-only memory mapping of the text file
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+
+#include <cstdio>
+#include <cstdlib>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct MappedFile {
+  const char *data = NULL;
+  size_t size = 0;
+};
+
+//************************************
+// Map the whole file read-only; the pages are shared with the page cache
+//************************************
+MappedFile map_text_file(const char *path) {
+  MappedFile f;
+#ifndef _WIN32
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("Couldn't find the text file");
+    exit(1);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    perror("Couldn't map the text file");
+    exit(1);
+  }
+  void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    perror("Couldn't map the text file");
+    exit(1);
+  }
+  // the text is scanned front to back, let the kernel read ahead aggressively
+  madvise(p, st.st_size, MADV_SEQUENTIAL);
+  f.data = (const char *)p;
+  f.size = st.st_size;
+#else
+  fprintf(stderr, "Memory mapped input is not supported on this platform\n");
+  exit(1);
+#endif
+  return f;
+}
+
+void unmap_text_file(MappedFile &f) {
+#ifndef _WIN32
+  if (f.data != NULL)
+    munmap((void *)f.data, f.size);
+#endif
+  f.data = NULL;
+  f.size = 0;
+}
+
+#endif
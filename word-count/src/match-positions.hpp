@@ -0,0 +1,165 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: positions of the four-character keywords
+//
+// The matches are written out with stream compaction rather than atomics:
+// every work-item first counts the matches in its slice, an exclusive
+// prefix sum over these counts gives each work-item the first output slot
+// of its matches, and a second pass over the text writes them there. The
+// slices are laid out in text order, so the output comes out sorted by
+// offset without any sorting step.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __MATCH_POSITIONS_HPP__
+#define __MATCH_POSITIONS_HPP__
+
+#include <algorithm>
+#include <vector>
+#include "word-count.hpp"
+#include "prefix-sum.hpp"
+
+// one keyword occurrence: the keyword's index and the offset of its first byte
+struct KeywordMatch {
+  uint64_t offset;
+  uint32_t keyword;
+};
+
+inline bool operator==(const KeywordMatch &a, const KeywordMatch &b) {
+  return a.offset == b.offset && a.keyword == b.keyword;
+}
+
+//************************************
+// Find every keyword occurrence in DPC++ on device:
+//************************************
+void match_positions(queue &q, uint32_t n_wgroups, int wgroup_size,
+  const std::vector<char4> &pattern, const char *text, size_t text_size,
+  size_t chars_per_item, std::vector<KeywordMatch> &matches)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  char4 keywords[NUM_KEYWORDS];
+  for (int k = 0; k < NUM_KEYWORDS; k++)
+    keywords[k] = pattern[k];
+
+  size_t num_items = (size_t)n_wgroups * wgroup_size;
+  buffer<char,1> text_buf(text, range<1>(text_size));
+  buffer<uint32_t,1> item_count_buf{range<1>(num_items)};
+  buffer<uint64_t,1> item_slot_buf{range<1>(num_items)};
+  buffer<uint64_t,1> total_buf{range<1>(1)};
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  // pass 1: every work-item counts the matches in its slice
+  event count_event = q.submit([&] (handler& h) {
+    auto text_mem = text_buf.get_access<access::mode::read>(h);
+    auto count_mem = item_count_buf.get_access<access::mode::discard_write>(h);
+    auto text_max_len = text_size;
+
+    h.parallel_for<class match_count_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t global_id = item.get_global_id(0);
+        size_t item_offset = global_id * chars_per_item;
+        uint32_t count = 0;
+        for (size_t i = item_offset; i < item_offset + chars_per_item; i++) {
+          if (i + KEYWORD_LEN > text_max_len)
+            break;
+          char4 text_word;
+          text_word.load(0, text_mem.get_pointer()+i);
+          for (int k = 0; k < NUM_KEYWORDS; k++)
+            if (text_word.x() == keywords[k].x() &&
+                text_word.y() == keywords[k].y() &&
+                text_word.z() == keywords[k].z() &&
+                text_word.w() == keywords[k].w())
+              count++;
+        }
+        count_mem[global_id] = count;
+    }); // parallel_for
+  }); // q.submit
+
+  // pass 2: the exclusive prefix sum of the counts is each work-item's first slot
+  event scan_event = submit_exclusive_scan(q, wgroup_size, item_count_buf, num_items,
+    item_slot_buf, total_buf);
+
+  uint64_t total = scan_total(total_buf);
+  matches.resize(total);
+  std::cout << "matches = " << total << std::endl;
+
+  if (total != 0) {
+    buffer<KeywordMatch,1> match_buf(matches.data(), range<1>(total));
+
+    // pass 3: every work-item rescans its slice and writes its matches in order
+    event write_event = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto slot_mem = item_slot_buf.get_access<access::mode::read>(h);
+      auto match_mem = match_buf.get_access<access::mode::discard_write>(h);
+      auto text_max_len = text_size;
+
+      h.parallel_for<class match_write_kernel>(
+        nd_range<1>(num_items, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t global_id = item.get_global_id(0);
+          size_t item_offset = global_id * chars_per_item;
+          uint64_t slot = slot_mem[global_id];
+          for (size_t i = item_offset; i < item_offset + chars_per_item; i++) {
+            if (i + KEYWORD_LEN > text_max_len)
+              break;
+            char4 text_word;
+            text_word.load(0, text_mem.get_pointer()+i);
+            for (int k = 0; k < NUM_KEYWORDS; k++)
+              if (text_word.x() == keywords[k].x() &&
+                  text_word.y() == keywords[k].y() &&
+                  text_word.z() == keywords[k].z() &&
+                  text_word.w() == keywords[k].w())
+                match_mem[slot++] = {i, (uint32_t)k};
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    total_kernel_time_ns +=
+      write_event.get_profiling_info<info::event_profiling::command_end>() -
+      write_event.get_profiling_info<info::event_profiling::command_start>();
+#endif
+  } // match_buf copies the matches back to host here
+
+#if FPGA || FPGA_PROFILE
+  // Query the events for kernel profiling information
+  total_kernel_time_ns +=
+    (count_event.get_profiling_info<info::event_profiling::command_end>() -
+     count_event.get_profiling_info<info::event_profiling::command_start>()) +
+    (scan_event.get_profiling_info<info::event_profiling::command_end>() -
+     scan_event.get_profiling_info<info::event_profiling::command_start>());
+  std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+}
+
+//************************************
+// Keyword positions on host, used to validate the device results
+//************************************
+void match_positions_host(const std::vector<char4> &pattern, const char *text,
+  size_t text_size, std::vector<KeywordMatch> &matches)
+{
+  matches.clear();
+  for (size_t i = 0; i + KEYWORD_LEN <= text_size; i++)
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      if (text[i] == pattern[k][0] &&
+          text[i+1] == pattern[k][1] &&
+          text[i+2] == pattern[k][2] &&
+          text[i+3] == pattern[k][3])
+        matches.push_back({i, (uint32_t)k});
+}
+
+#endif
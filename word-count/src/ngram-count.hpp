@@ -0,0 +1,342 @@
+//==============================================================
+// DPC++ Example
+//
+// N-gram frequency tables for Word Count
+//
+// Counts every sequence of n consecutive tokens (bigrams, trigrams, ...)
+// with sort-and-reduce rather than a hash table: the text is tokenized on
+// device, every n-gram becomes a 64-bit key hashed from its tokens, the
+// keys are radix sorted and runs of equal keys are reduced to (n-gram,
+// count) pairs. Unlike hash table inserts, the cost does not depend on how
+// skewed the n-gram distribution is.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __NGRAM_COUNT_HPP__
+#define __NGRAM_COUNT_HPP__
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "word-count.hpp"
+#include "prefix-sum.hpp"
+#include "radix-sort.hpp"
+#include "word-histogram.hpp"
+
+// longest n-gram counted
+constexpr int NGRAM_MAX_N = 8;
+
+struct NgramTable {
+  uint64_t total_ngrams = 0;
+  uint64_t distinct_ngrams = 0;
+  std::vector<WordFreq> ngrams;   // most frequent first
+};
+
+// mix the token hashes of an n-gram into its key; the 64-bit finalizer of
+// MurmurHash3 keeps "a b" and "b a" apart
+inline uint64_t mix_ngram_hash(uint64_t h, uint64_t token_hash) {
+  h = (h ^ token_hash) * FNV_PRIME;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+// the n-gram made of tokens first .. first+n-1, joined with single spaces
+inline std::string ngram_text(const char *text, const uint64_t *pos, const uint32_t *lens,
+  size_t first, int n)
+{
+  std::string s(text + pos[first], lens[first]);
+  for (int j = 1; j < n; j++) {
+    s += ' ';
+    s.append(text + pos[first + j], lens[first + j]);
+  }
+  return s;
+}
+
+//************************************
+// N-gram frequencies in DPC++ on device:
+//************************************
+// 1. tokenize: each work-item counts the tokens starting in its slice, an
+//    exclusive prefix sum gives it the index of its first token, and a
+//    second pass writes the hash, position and length of its tokens
+// 2. key: every n-gram index g gets the key hashed from tokens g .. g+n-1
+// 3. radix sort the (key, g) pairs
+// 4. reduce: each run of equal keys becomes one (key, count) entry, with
+//    the first n-gram of the run kept to print its text
+// With top_k != 0 only the top_k most frequent n-grams are selected on
+// device and read back, otherwise the whole table is.
+void ngram_count(queue &q, uint32_t n_wgroups, int wgroup_size, const char *text,
+  size_t text_size, size_t chars_per_item, int n, size_t top_k, NgramTable &table)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+  auto kernel_time = [](event &e) {
+    return e.get_profiling_info<info::event_profiling::command_end>() -
+           e.get_profiling_info<info::event_profiling::command_start>();
+  };
+#endif
+  size_t num_items = (size_t)n_wgroups * wgroup_size;
+  table.total_ngrams = 0;
+  table.distinct_ngrams = 0;
+  table.ngrams.clear();
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  buffer<char,1> text_buf(text, range<1>(text_size));
+  buffer<uint32_t,1> item_count_buf{range<1>(num_items)};
+  buffer<uint64_t,1> item_slot_buf{range<1>(num_items)};
+  buffer<uint64_t,1> total_buf{range<1>(1)};
+
+  // pass 1: every work-item counts the tokens starting in its slice
+  event token_count_event = q.submit([&] (handler& h) {
+    auto text_mem = text_buf.get_access<access::mode::read>(h);
+    auto count_mem = item_count_buf.get_access<access::mode::discard_write>(h);
+    auto text_max_len = text_size;
+
+    h.parallel_for<class ngram_token_count_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t global_id = item.get_global_id(0);
+        size_t begin = std::min(text_max_len, global_id * chars_per_item);
+        size_t end = std::min(text_max_len, begin + chars_per_item);
+        uint32_t count = 0;
+        bool prev_word = begin > 0 && is_word_char(text_mem[begin - 1]);
+        for (size_t i = begin; i < end; i++) {
+          bool word = is_word_char(text_mem[i]);
+          if (word && !prev_word)
+            count++;
+          prev_word = word;
+        }
+        count_mem[global_id] = count;
+    }); // parallel_for
+  }); // q.submit
+
+  event token_scan_event = submit_exclusive_scan(q, wgroup_size, item_count_buf, num_items,
+    item_slot_buf, total_buf);
+  uint64_t num_tokens = scan_total(total_buf);
+  std::cout << "tokens = " << num_tokens << std::endl;
+  if (num_tokens < (uint64_t)n)
+    return;
+  size_t num_ngrams = num_tokens - n + 1;
+  table.total_ngrams = num_ngrams;
+
+  buffer<uint64_t,1> token_hash_buf{range<1>(num_tokens)};
+  buffer<uint64_t,1> token_pos_buf{range<1>(num_tokens)};
+  buffer<uint32_t,1> token_len_buf{range<1>(num_tokens)};
+
+  // pass 2: every work-item writes its tokens, in text order; a token that
+  // runs past the end of the slice belongs to the slice it starts in
+  event token_write_event = q.submit([&] (handler& h) {
+    auto text_mem = text_buf.get_access<access::mode::read>(h);
+    auto slot_mem = item_slot_buf.get_access<access::mode::read>(h);
+    auto hash_mem = token_hash_buf.get_access<access::mode::discard_write>(h);
+    auto pos_mem = token_pos_buf.get_access<access::mode::discard_write>(h);
+    auto len_mem = token_len_buf.get_access<access::mode::discard_write>(h);
+    auto text_max_len = text_size;
+
+    h.parallel_for<class ngram_token_write_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t global_id = item.get_global_id(0);
+        size_t begin = std::min(text_max_len, global_id * chars_per_item);
+        size_t end = std::min(text_max_len, begin + chars_per_item);
+        uint64_t slot = slot_mem[global_id];
+        size_t i = begin;
+        // skip the tail of a token started in the previous slice
+        if (i > 0 && is_word_char(text_mem[i - 1]))
+          while (i < end && is_word_char(text_mem[i]))
+            i++;
+        while (i < end) {
+          if (!is_word_char(text_mem[i])) {
+            i++;
+            continue;
+          }
+          size_t start = i;
+          uint64_t hash = FNV_OFFSET;
+          while (i < text_max_len && is_word_char(text_mem[i])) {
+            hash = (hash ^ (unsigned char)text_mem[i]) * FNV_PRIME;
+            i++;
+          }
+          hash_mem[slot] = finish_token_hash(hash);
+          pos_mem[slot] = start;
+          len_mem[slot] = i - start;
+          slot++;
+        }
+    }); // parallel_for
+  }); // q.submit
+
+  buffer<uint64_t,1> keys_buf{range<1>(num_ngrams)};
+  buffer<uint32_t,1> vals_buf{range<1>(num_ngrams)};
+  buffer<uint64_t,1> tmp_keys_buf{range<1>(num_ngrams)};
+  buffer<uint32_t,1> tmp_vals_buf{range<1>(num_ngrams)};
+
+  event key_event = q.submit([&] (handler& h) {
+    auto hash_mem = token_hash_buf.get_access<access::mode::read>(h);
+    auto keys = keys_buf.get_access<access::mode::discard_write>(h);
+    auto vals = vals_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<class ngram_key_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        for (size_t g = item.get_global_id(0); g < num_ngrams; g += num_items) {
+          uint64_t key = FNV_OFFSET;
+          for (int j = 0; j < n; j++)
+            key = mix_ngram_hash(key, hash_mem[g + j]);
+          keys[g] = finish_token_hash(key);
+          vals[g] = g;
+        }
+    }); // parallel_for
+  }); // q.submit
+
+  radix_sort_pairs(q, n_wgroups, wgroup_size, keys_buf, vals_buf, tmp_keys_buf, tmp_vals_buf,
+    num_ngrams);
+
+  // reduce, pass 1: every work-item counts the runs starting in its block
+  size_t per_item = (num_ngrams + num_items - 1) / num_items;
+  event head_count_event = q.submit([&] (handler& h) {
+    auto keys = keys_buf.get_access<access::mode::read>(h);
+    auto count_mem = item_count_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<class ngram_head_count_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t global_id = item.get_global_id(0);
+        size_t begin = std::min(num_ngrams, global_id * per_item);
+        size_t end = std::min(num_ngrams, begin + per_item);
+        uint32_t count = 0;
+        for (size_t i = begin; i < end; i++)
+          if (i == 0 || keys[i] != keys[i - 1])
+            count++;
+        count_mem[global_id] = count;
+    }); // parallel_for
+  }); // q.submit
+
+  event head_scan_event = submit_exclusive_scan(q, wgroup_size, item_count_buf, num_items,
+    item_slot_buf, total_buf);
+  uint64_t num_distinct = scan_total(total_buf);
+  table.distinct_ngrams = num_distinct;
+  std::cout << "n-grams = " << num_ngrams << ", distinct = " << num_distinct << std::endl;
+
+  buffer<uint64_t,1> unique_keys_buf{range<1>(num_distinct)};
+  buffer<uint32_t,1> unique_counts_buf{range<1>(num_distinct)};
+  buffer<uint32_t,1> unique_first_buf{range<1>(num_distinct)};
+
+  // reduce, pass 2: every run is written by the work-item it starts in,
+  // following it into the next blocks if needed
+  event reduce_event = q.submit([&] (handler& h) {
+    auto keys = keys_buf.get_access<access::mode::read>(h);
+    auto vals = vals_buf.get_access<access::mode::read>(h);
+    auto slot_mem = item_slot_buf.get_access<access::mode::read>(h);
+    auto unique_keys = unique_keys_buf.get_access<access::mode::discard_write>(h);
+    auto unique_counts = unique_counts_buf.get_access<access::mode::discard_write>(h);
+    auto unique_first = unique_first_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<class ngram_reduce_kernel>(
+      nd_range<1>(num_items, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t global_id = item.get_global_id(0);
+        size_t begin = std::min(num_ngrams, global_id * per_item);
+        size_t end = std::min(num_ngrams, begin + per_item);
+        uint64_t slot = slot_mem[global_id];
+        for (size_t i = begin; i < end; i++) {
+          if (i != 0 && keys[i] == keys[i - 1])
+            continue;
+          size_t run_end = i + 1;
+          while (run_end < num_ngrams && keys[run_end] == keys[i])
+            run_end++;
+          unique_keys[slot] = keys[i];
+          unique_counts[slot] = run_end - i;
+          // the sort is stable, so this is the run's first n-gram in the text
+          unique_first[slot] = vals[i];
+          slot++;
+        }
+    }); // parallel_for
+  }); // q.submit
+
+#if FPGA || FPGA_PROFILE
+  total_kernel_time_ns += kernel_time(token_count_event) + kernel_time(token_scan_event) +
+    kernel_time(token_write_event) + kernel_time(key_event) + kernel_time(head_count_event) +
+    kernel_time(head_scan_event) + kernel_time(reduce_event);
+  std::cout << " Tokenize and reduce compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+
+  // the selection kernels run before any host accessor is taken
+  std::vector<uint32_t> top_slots;
+  if (top_k != 0)
+    top_slots = select_top_slots(q, n_wgroups, wgroup_size, unique_keys_buf,
+      unique_counts_buf, top_k, table.distinct_ngrams);
+
+  auto pos = token_pos_buf.get_access<access::mode::read>();
+  auto lens = token_len_buf.get_access<access::mode::read>();
+  auto counts = unique_counts_buf.get_access<access::mode::read>();
+  auto first = unique_first_buf.get_access<access::mode::read>();
+  if (top_k != 0) {
+    for (auto s : top_slots)
+      table.ngrams.push_back({ngram_text(text, pos.get_pointer(), lens.get_pointer(), first[s], n),
+                              counts[s]});
+  } else {
+    for (size_t s = 0; s < num_distinct; s++)
+      table.ngrams.push_back({ngram_text(text, pos.get_pointer(), lens.get_pointer(), first[s], n),
+                              counts[s]});
+  }
+  std::sort(table.ngrams.begin(), table.ngrams.end(), word_freq_before);
+}
+
+//************************************
+// N-gram frequencies on host, used to validate the device results
+//************************************
+void ngram_count_host(const char *text, size_t text_size, int n, size_t top_k,
+  NgramTable &table)
+{
+  std::vector<std::string> tokens;
+  size_t i = 0;
+  while (i < text_size) {
+    if (!is_word_char(text[i])) {
+      i++;
+      continue;
+    }
+    size_t start = i;
+    while (i < text_size && is_word_char(text[i]))
+      i++;
+    tokens.push_back(std::string(text + start, i - start));
+  }
+
+  std::unordered_map<std::string, uint32_t> ngrams;
+  table.total_ngrams = tokens.size() >= (size_t)n ? tokens.size() - n + 1 : 0;
+  for (size_t g = 0; g < table.total_ngrams; g++) {
+    std::string s = tokens[g];
+    for (int j = 1; j < n; j++)
+      s += ' ' + tokens[g + j];
+    ngrams[s]++;
+  }
+
+  table.distinct_ngrams = ngrams.size();
+  table.ngrams.clear();
+  for (auto &w : ngrams)
+    table.ngrams.push_back({w.first, w.second});
+  if (top_k == 0 || top_k > table.ngrams.size())
+    top_k = table.ngrams.size();
+  std::partial_sort(table.ngrams.begin(), table.ngrams.begin() + top_k, table.ngrams.end(),
+    word_freq_before);
+  table.ngrams.resize(top_k);
+}
+
+#endif
@@ -0,0 +1,87 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: exclusive prefix sum on device
+//
+// Used wherever work-items first count how many outputs they produce and
+// then need the first output slot of each: keyword positions, tokens,
+// radix sort buckets.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __PREFIX_SUM_HPP__
+#define __PREFIX_SUM_HPP__
+
+#include <algorithm>
+#include "word-count.hpp"
+
+//************************************
+// Exclusive prefix sum of the num counts in count_buf into slot_buf; the
+// sum of all counts goes to total_buf[0]
+//************************************
+// A single work-group does the scan: each work-item sums a contiguous block
+// of counts, the block sums are scanned in local memory (Hillis-Steele),
+// and each work-item then turns its block into slots.
+event submit_exclusive_scan(queue &q, int wgroup_size, buffer<uint32_t,1> &count_buf,
+  size_t num, buffer<uint64_t,1> &slot_buf, buffer<uint64_t,1> &total_buf)
+{
+  auto local_mem_size = q.get_device().get_info<info::device::local_mem_size>();
+  if (local_mem_size < wgroup_size * sizeof(uint64_t))
+    throw "Device doesn't have enough local memory!";
+
+  return q.submit([&] (handler& h) {
+    accessor <uint64_t, 1,
+      access::mode::read_write,
+      access::target::local>
+    local_sum(range<1>(wgroup_size), h);
+
+    auto count_mem = count_buf.get_access<access::mode::read>(h);
+    auto slot_mem = slot_buf.get_access<access::mode::discard_write>(h);
+    auto total_mem = total_buf.get_access<access::mode::discard_write>(h);
+
+    h.parallel_for<class exclusive_scan_kernel>(
+      nd_range<1>(wgroup_size, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t local_id = item.get_local_id(0);
+        size_t per_item = (num + wgroup_size - 1) / wgroup_size;
+        size_t begin = std::min(num, local_id * per_item);
+        size_t end = std::min(num, begin + per_item);
+
+        uint64_t block_sum = 0;
+        for (size_t i = begin; i < end; i++)
+          block_sum += count_mem[i];
+        local_sum[local_id] = block_sum;
+        item.barrier(sycl::access::fence_space::local_space);
+
+        for (size_t d = 1; d < (size_t)wgroup_size; d <<= 1) {
+          uint64_t add = local_id >= d ? local_sum[local_id - d] : 0;
+          item.barrier(sycl::access::fence_space::local_space);
+          local_sum[local_id] += add;
+          item.barrier(sycl::access::fence_space::local_space);
+        }
+
+        uint64_t slot = local_sum[local_id] - block_sum;
+        for (size_t i = begin; i < end; i++) {
+          slot_mem[i] = slot;
+          slot += count_mem[i];
+        }
+        if (local_id == (size_t)wgroup_size - 1)
+          total_mem[0] = local_sum[local_id];
+    }); // parallel_for
+  }); // q.submit
+}
+
+// read back total_buf[0] (waits for the scan)
+uint64_t scan_total(buffer<uint64_t,1> &total_buf) {
+  auto total_host = total_buf.get_access<access::mode::read>();
+  return total_host[0];
+}
+
+#endif
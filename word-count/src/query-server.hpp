@@ -0,0 +1,324 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: query server over a device-resident text
+//
+// The text is copied to the device once. Keyword queries then arrive one
+// per line (keywords separated by blanks) on stdin or on a Unix socket,
+// and every query is answered with one line of "keyword count" pairs.
+// Queries that arrive within QUERY_FUSE_WINDOW_MS of each other are fused:
+// their keywords are deduplicated and counted in a single scan of the
+// resident text, so a burst of queries costs one pass over the data.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __QUERY_SERVER_HPP__
+#define __QUERY_SERVER_HPP__
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "word-count.hpp"
+
+// longest keyword a query may contain
+constexpr size_t QUERY_MAX_LEN = 32;
+// keywords counted by one scan; larger batches take several scans
+constexpr size_t QUERY_MAX_KEYWORDS = 256;
+// how long to wait for more queries to fuse with the first pending one
+constexpr int QUERY_FUSE_WINDOW_MS = 2;
+
+//************************************
+// Count num_keywords keywords (QUERY_MAX_LEN bytes apart in keyword_buf,
+// lengths in length_buf) in the first text_len characters of text_buf
+//************************************
+// Same slicing as reduction_kernel: each work-item scans chars_per_item
+// start positions by global id, reading past its slice for the keyword
+// tails. Counts go to local memory first, then one global atomic per
+// keyword per work-group.
+event submit_query_search(queue &q, buffer<char,1> &text_buf, size_t text_len,
+  uint32_t n_wgroups, int wgroup_size, buffer<char,1> &keyword_buf,
+  buffer<uint32_t,1> &length_buf, uint32_t num_keywords, size_t chars_per_item,
+  buffer<uint32_t,1> &result_buf)
+{
+  return q.submit([&] (handler& h) {
+    accessor <uint32_t, 1,
+      access::mode::read_write,
+      access::target::local>
+    local_mem(range<1>(QUERY_MAX_KEYWORDS), h);
+
+    auto text_mem = text_buf.get_access<access::mode::read>(h);
+    auto keyword_mem = keyword_buf.get_access<access::mode::read>(h);
+    auto length_mem = length_buf.get_access<access::mode::read>(h);
+    auto result_mem = result_buf.get_access<access::mode::read_write>(h);
+    auto text_max_len = text_len;
+
+    h.parallel_for<class query_kernel>(
+      nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      {
+        size_t local_id = item.get_local_id(0);
+        for (size_t k = local_id; k < num_keywords; k += wgroup_size)
+          local_mem[k] = 0;
+        item.barrier(sycl::access::fence_space::local_space);
+
+        size_t item_offset = item.get_global_id(0) * chars_per_item;
+        for (size_t i = item_offset; i < item_offset + chars_per_item; i++) {
+          if (i >= text_max_len)
+            break;
+          char c = text_mem[i];
+          for (uint32_t k = 0; k < num_keywords; k++) {
+            const size_t base = (size_t)k * QUERY_MAX_LEN;
+            uint32_t len = length_mem[k];
+            // test the first byte before paying for the bounds check
+            if (c != keyword_mem[base] || i + len > text_max_len)
+              continue;
+            uint32_t j = 1;
+            while (j < len && text_mem[i + j] == keyword_mem[base + j])
+              j++;
+            if (j == len)
+              local_atomic_ref<uint32_t>(local_mem[k])++;
+          }
+        }
+        item.barrier(sycl::access::fence_space::local_space);
+
+        for (size_t k = local_id; k < num_keywords; k += wgroup_size)
+          if (local_mem[k] != 0)
+            global_atomic_ref<uint32_t>(result_mem[k]) += local_mem[k];
+    }); // parallel_for
+  }); // q.submit
+}
+
+#ifndef _WIN32
+// one source of queries: stdin/stdout, or an accepted socket connection
+struct QueryClient {
+  int in_fd;
+  int out_fd;
+  std::string pending;  // bytes received after the last complete line
+  bool closed = false;
+};
+
+// one line received from a client
+struct Query {
+  size_t client;
+  std::vector<std::string> keywords;
+  std::string error;
+};
+
+void write_reply(QueryClient &c, const std::string &reply) {
+  // a client may have closed its input and still wait for the replies
+  size_t done = 0;
+  while (done < reply.size()) {
+    ssize_t n = c.in_fd == c.out_fd
+      ? send(c.out_fd, reply.data() + done, reply.size() - done, MSG_NOSIGNAL)
+      : write(c.out_fd, reply.data() + done, reply.size() - done);
+    if (n <= 0) {
+      c.closed = true;
+      return;
+    }
+    done += n;
+  }
+}
+
+// read what is available on client c and split off its complete lines
+void read_queries(std::vector<QueryClient> &clients, size_t c, std::vector<Query> &queries) {
+  char buf[4096];
+  ssize_t n = read(clients[c].in_fd, buf, sizeof(buf));
+  std::string &pending = clients[c].pending;
+  if (n <= 0) {
+    // a last line without a newline still counts
+    clients[c].closed = true;
+    if (pending.empty())
+      return;
+    pending += '\n';
+  } else {
+    pending.append(buf, n);
+  }
+  size_t eol;
+  while ((eol = pending.find('\n')) != std::string::npos) {
+    Query query;
+    query.client = c;
+    size_t i = 0;
+    while (i < eol) {
+      while (i < eol && isspace((unsigned char)pending[i]))
+        i++;
+      size_t start = i;
+      while (i < eol && !isspace((unsigned char)pending[i]))
+        i++;
+      if (i == start)
+        continue;
+      if (i - start > QUERY_MAX_LEN)
+        query.error = "error: keywords are limited to " + std::to_string(QUERY_MAX_LEN) + " bytes";
+      else
+        query.keywords.push_back(pending.substr(start, i - start));
+    }
+    pending.erase(0, eol + 1);
+    if (!query.keywords.empty() || !query.error.empty())
+      queries.push_back(query);
+  }
+}
+#endif
+
+//************************************
+// Serve keyword queries against a device-resident copy of the text:
+//************************************
+// With socket_path NULL the queries are read from stdin and answered on
+// stdout until end of input; otherwise the server listens on a Unix socket
+// at socket_path and answers every connection on its own socket.
+void serve_queries(queue &q, uint32_t n_wgroups, int wgroup_size, const char *text,
+  size_t text_size, size_t chars_per_item, const char *socket_path)
+{
+#ifndef _WIN32
+  auto local_mem_size = q.get_device().get_info<info::device::local_mem_size>();
+  if (local_mem_size < QUERY_MAX_KEYWORDS * sizeof(uint32_t))
+    throw "Device doesn't have enough local memory!";
+
+  // copy the text to the device once, every scan reuses it
+  dpc_common::TimeInterval load_time;
+  buffer<char,1> text_buf{range<1>(text_size)};
+  q.submit([&] (handler& h) {
+    auto text_mem = text_buf.get_access<access::mode::discard_write>(h);
+    h.copy(text, text_mem);
+  }).wait();
+  std::cout << "text loaded to device in " << load_time.Elapsed() * 1000 << " ms" << std::endl;
+
+  std::vector<QueryClient> clients;
+  int listen_fd = -1;
+  if (socket_path != NULL) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "Socket path is too long\n");
+      exit(1);
+    }
+    strcpy(addr.sun_path, socket_path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 16) != 0) {
+      perror("Couldn't listen on the query socket");
+      exit(1);
+    }
+    std::cout << "listening on " << socket_path << std::endl;
+  } else {
+    clients.push_back({STDIN_FILENO, STDOUT_FILENO});
+    std::cout << "reading queries from stdin" << std::endl;
+  }
+
+  std::vector<Query> queries;
+  while (listen_fd >= 0 || !clients.empty()) {
+    // block for the first query, then give others a short window to join it
+    dpc_common::TimeInterval fuse_time;
+    for (;;) {
+      int timeout = -1;
+      if (!queries.empty()) {
+        timeout = QUERY_FUSE_WINDOW_MS - (int)(fuse_time.Elapsed() * 1000);
+        if (timeout <= 0)
+          break;
+      }
+      // closed clients are no longer polled, they are dropped after the scan
+      std::vector<struct pollfd> fds;
+      std::vector<size_t> fd_client;
+      for (size_t c = 0; c < clients.size(); c++)
+        if (!clients[c].closed) {
+          fds.push_back({clients[c].in_fd, POLLIN, 0});
+          fd_client.push_back(c);
+        }
+      if (listen_fd >= 0)
+        fds.push_back({listen_fd, POLLIN, 0});
+      if (fds.empty() || poll(fds.data(), fds.size(), timeout) <= 0)
+        break;
+
+      bool was_idle = queries.empty();
+      for (size_t f = 0; f < fd_client.size(); f++)
+        if (fds[f].revents & (POLLIN | POLLHUP | POLLERR))
+          read_queries(clients, fd_client[f], queries);
+      if (listen_fd >= 0 && (fds.back().revents & POLLIN)) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd >= 0)
+          clients.push_back({fd, fd});
+      }
+      if (was_idle)
+        fuse_time = dpc_common::TimeInterval();
+      // stop waiting once a client has gone, so that it is dropped promptly
+      bool any_closed = false;
+      for (auto &c : clients)
+        any_closed |= c.closed;
+      if (any_closed)
+        break;
+    }
+
+    if (!queries.empty()) {
+      // gather the distinct keywords of all pending queries
+      std::map<std::string, uint32_t> keyword_id;
+      std::vector<std::string> keywords;
+      for (auto &query : queries)
+        for (auto &w : query.keywords)
+          if (keyword_id.emplace(w, keywords.size()).second)
+            keywords.push_back(w);
+
+      dpc_common::TimeInterval scan_time;
+      std::vector<uint32_t> counts(keywords.size(), 0);
+      for (size_t first = 0; first < keywords.size(); first += QUERY_MAX_KEYWORDS) {
+        uint32_t num = std::min(QUERY_MAX_KEYWORDS, keywords.size() - first);
+        std::vector<char> packed((size_t)num * QUERY_MAX_LEN, 0);
+        std::vector<uint32_t> lengths(num);
+        for (uint32_t k = 0; k < num; k++) {
+          const std::string &w = keywords[first + k];
+          memcpy(&packed[(size_t)k * QUERY_MAX_LEN], w.data(), w.size());
+          lengths[k] = w.size();
+        }
+        buffer<char,1> keyword_buf(packed.data(), range<1>(packed.size()));
+        buffer<uint32_t,1> length_buf(lengths.data(), range<1>(num));
+        buffer<uint32_t,1> result_buf(counts.data() + first, range<1>(num));
+        submit_query_search(q, text_buf, text_size, n_wgroups, wgroup_size,
+          keyword_buf, length_buf, num, chars_per_item, result_buf);
+      } // buffers copy the counts back to host here
+      std::cerr << "fused " << queries.size() << " queries, " << keywords.size()
+                << " keywords, scan time " << scan_time.Elapsed() * 1000 << " ms" << std::endl;
+
+      for (auto &query : queries) {
+        std::string reply = query.error;
+        for (auto &w : query.keywords) {
+          if (!query.error.empty())
+            break;
+          if (!reply.empty())
+            reply += ' ';
+          reply += w + ' ' + std::to_string(counts[keyword_id[w]]);
+        }
+        write_reply(clients[query.client], reply + '\n');
+      }
+      queries.clear();
+    }
+
+    // drop the finished clients; queries never refer to them past this point
+    for (size_t c = clients.size(); c-- > 0;)
+      if (clients[c].closed) {
+        if (clients[c].in_fd != STDIN_FILENO)
+          close(clients[c].in_fd);
+        clients.erase(clients.begin() + c);
+      }
+  }
+#else
+  fprintf(stderr, "Query server mode is not supported on this platform\n");
+  exit(1);
+#endif
+}
+
+#endif
@@ -0,0 +1,225 @@
+//==============================================================
+// DPC++ Example
+//
+// Rabin-Karp multi-keyword search for Word Count
+//
+// Keywords of any length from 1 to 64 bytes are grouped by length. For
+// each length, a polynomial hash of the window ending at every text
+// position is rolled forward with two multiply-adds per byte and looked up
+// in a small open-addressing hash set of that length's keywords; only a
+// hash hit is verified byte by byte.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __RABIN_KARP_HPP__
+#define __RABIN_KARP_HPP__
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "word-count.hpp"
+
+constexpr size_t RK_MAX_KEYWORD_LEN = 64;
+// base of the hash polynomial, arithmetic is modulo 2^64
+constexpr uint64_t RK_BASE = 0x100000001b3ull;
+constexpr uint32_t RK_EMPTY = UINT32_MAX;
+
+struct RKDictionary {
+  std::vector<std::string> keywords;
+  // duplicate keywords are searched once: keyword k is counted as unique[k]
+  std::vector<uint32_t> unique;
+  std::vector<std::string> unique_keywords;
+  std::vector<char> chars;                  // the unique keywords back to back
+  std::vector<uint32_t> char_offset;        // where each one starts in chars
+  // one group per distinct keyword length
+  std::vector<uint32_t> group_len;
+  std::vector<uint64_t> group_pow;          // RK_BASE^len
+  std::vector<uint32_t> group_slot;         // first slot of the group's hash set
+  std::vector<uint32_t> group_bits;         // the set has 2^bits slots
+  // hash sets of all groups back to back: keyword hash and unique keyword index
+  std::vector<uint64_t> slot_hash;
+  std::vector<uint32_t> slot_keyword;
+};
+
+inline uint64_t rk_hash(const char *s, size_t len) {
+  uint64_t h = 0;
+  for (size_t i = 0; i < len; i++)
+    h = h * RK_BASE + (unsigned char)s[i];
+  return h;
+}
+
+// the top bits of a Fibonacci hash pick the first slot to probe
+inline uint32_t rk_slot(uint64_t h, uint32_t bits) {
+  return (h * 0x9e3779b97f4a7c15ull) >> (64 - bits);
+}
+
+//************************************
+// Build the hash sets of the keywords on host
+//************************************
+RKDictionary build_rk_dictionary(const std::vector<std::string> &keywords) {
+  RKDictionary rk;
+  rk.keywords = keywords;
+  std::map<std::string, uint32_t> seen;
+  std::map<size_t, std::vector<uint32_t>> by_len;
+  for (auto &w : keywords) {
+    if (w.size() > RK_MAX_KEYWORD_LEN) {
+      std::cout << "Keyword " << w << " is longer than " << RK_MAX_KEYWORD_LEN
+                << " characters" << std::endl;
+      exit(1);
+    }
+    auto it = seen.find(w);
+    if (it == seen.end()) {
+      uint32_t u = rk.unique_keywords.size();
+      it = seen.emplace(w, u).first;
+      rk.unique_keywords.push_back(w);
+      rk.char_offset.push_back(rk.chars.size());
+      rk.chars.insert(rk.chars.end(), w.begin(), w.end());
+      by_len[w.size()].push_back(u);
+    }
+    rk.unique.push_back(it->second);
+  }
+
+  for (auto &group : by_len) {
+    // at most half full, so probe sequences stay short
+    uint32_t bits = 1;
+    while ((1u << bits) < 2 * group.second.size())
+      bits++;
+    uint32_t first_slot = rk.slot_hash.size();
+    rk.group_len.push_back(group.first);
+    rk.group_pow.push_back(1);
+    for (size_t i = 0; i < group.first; i++)
+      rk.group_pow.back() *= RK_BASE;
+    rk.group_slot.push_back(first_slot);
+    rk.group_bits.push_back(bits);
+    rk.slot_hash.resize(first_slot + (1u << bits), 0);
+    rk.slot_keyword.resize(first_slot + (1u << bits), RK_EMPTY);
+    for (auto u : group.second) {
+      uint64_t h = rk_hash(rk.unique_keywords[u].data(), group.first);
+      uint32_t mask = (1u << bits) - 1;
+      uint32_t s = rk_slot(h, bits);
+      while (rk.slot_keyword[first_slot + s] != RK_EMPTY)
+        s = (s + 1) & mask;
+      rk.slot_hash[first_slot + s] = h;
+      rk.slot_keyword[first_slot + s] = u;
+    }
+  }
+  return rk;
+}
+
+//************************************
+// Rabin-Karp keyword count in DPC++ on device:
+//************************************
+// Each work-item counts the keywords *starting* in its slice, one length
+// group after the other; the window of a group starting at the end of the
+// slice reads up to len-1 bytes past it.
+void rk_search(queue &q, uint32_t n_wgroups, int wgroup_size, const RKDictionary &rk,
+  const char *text, size_t text_size, size_t chars_per_item, std::vector<uint32_t> &counts)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  uint32_t num_groups = rk.group_len.size();
+  std::vector<uint32_t> hits(rk.unique_keywords.size(), 0);
+
+  {
+    buffer<char, 1> text_buf(text, range<1>(text_size));
+    buffer<char, 1> chars_buf(rk.chars.data(), range<1>(rk.chars.size()));
+    buffer<uint32_t, 1> char_offset_buf(rk.char_offset.data(), range<1>(rk.char_offset.size()));
+    buffer<uint32_t, 1> len_buf(rk.group_len.data(), range<1>(num_groups));
+    buffer<uint64_t, 1> pow_buf(rk.group_pow.data(), range<1>(num_groups));
+    buffer<uint32_t, 1> group_slot_buf(rk.group_slot.data(), range<1>(num_groups));
+    buffer<uint32_t, 1> bits_buf(rk.group_bits.data(), range<1>(num_groups));
+    buffer<uint64_t, 1> slot_hash_buf(rk.slot_hash.data(), range<1>(rk.slot_hash.size()));
+    buffer<uint32_t, 1> slot_keyword_buf(rk.slot_keyword.data(), range<1>(rk.slot_keyword.size()));
+    buffer<uint32_t, 1> hits_buf(hits.data(), range<1>(hits.size()));
+
+    std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+    std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+    event e = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto chars = chars_buf.get_access<access::mode::read>(h);
+      auto char_offset = char_offset_buf.get_access<access::mode::read>(h);
+      auto group_len = len_buf.get_access<access::mode::read>(h);
+      auto group_pow = pow_buf.get_access<access::mode::read>(h);
+      auto group_slot = group_slot_buf.get_access<access::mode::read>(h);
+      auto group_bits = bits_buf.get_access<access::mode::read>(h);
+      auto slot_hash = slot_hash_buf.get_access<access::mode::read>(h);
+      auto slot_keyword = slot_keyword_buf.get_access<access::mode::read>(h);
+      auto hits_mem = hits_buf.get_access<access::mode::read_write>(h);
+
+      auto text_max_len = text_size;
+
+      h.parallel_for<class rk_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t begin = item.get_global_id(0) * chars_per_item;
+          size_t end = begin + chars_per_item;
+          if (end > text_max_len)
+            end = text_max_len;
+
+          for (uint32_t g = 0; g < num_groups; g++) {
+            size_t len = group_len[g];
+            if (begin + len > text_max_len)
+              continue;
+            uint64_t pow = group_pow[g];
+            uint32_t first_slot = group_slot[g];
+            uint32_t bits = group_bits[g];
+            uint32_t mask = (1u << bits) - 1;
+
+            uint64_t hash = 0;
+            for (size_t j = 0; j < len; j++)
+              hash = hash * RK_BASE + (unsigned char)text_mem[begin + j];
+            for (size_t i = begin; ; ) {
+              for (uint32_t s = rk_slot(hash, bits); ; s = (s + 1) & mask) {
+                uint32_t u = slot_keyword[first_slot + s];
+                if (u == RK_EMPTY)
+                  break;
+                if (slot_hash[first_slot + s] != hash)
+                  continue;
+                size_t j = 0;
+                uint32_t offset = char_offset[u];
+                while (j < len && text_mem[i + j] == chars[offset + j])
+                  j++;
+                if (j == len) {
+                  global_atomic_ref<uint32_t>(hits_mem[u])++;
+                  break;
+                }
+              }
+              if (i + 1 >= end || i + len >= text_max_len)
+                break;
+              // drop text[i], take in text[i + len]
+              hash = hash * RK_BASE + (unsigned char)text_mem[i + len]
+                     - pow * (unsigned char)text_mem[i];
+              i++;
+            }
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    total_kernel_time_ns += kernel_time_ns;
+
+    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // buffers copy the hit counts back to host here
+
+  counts.resize(rk.keywords.size());
+  for (size_t k = 0; k < rk.keywords.size(); k++)
+    counts[k] = hits[rk.unique[k]];
+}
+
+#endif
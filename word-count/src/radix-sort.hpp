@@ -0,0 +1,122 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: key-value radix sort on device
+//
+// LSD radix sort of 64-bit keys carrying 32-bit values, 8 bits per pass.
+// Every work-item owns a contiguous block of the input and, per pass,
+// counts the digits of its block; an exclusive prefix sum over the counts
+// laid out digit-major gives each (digit, work-item) pair its first output
+// slot, and the work-items then scatter their blocks in order. The sort is
+// therefore stable and needs no atomics.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __RADIX_SORT_HPP__
+#define __RADIX_SORT_HPP__
+
+#include <algorithm>
+#include "word-count.hpp"
+#include "prefix-sum.hpp"
+
+constexpr int SORT_RADIX_BITS = 8;
+constexpr int SORT_RADIX_BINS = 1 << SORT_RADIX_BITS;
+
+//************************************
+// Sort the first num pairs of keys_buf/vals_buf by the low key_bits bits of
+// the keys; tmp_keys_buf/tmp_vals_buf are scratch of the same size
+//************************************
+void radix_sort_pairs(queue &q, uint32_t n_wgroups, int wgroup_size,
+  buffer<uint64_t,1> &keys_buf, buffer<uint32_t,1> &vals_buf,
+  buffer<uint64_t,1> &tmp_keys_buf, buffer<uint32_t,1> &tmp_vals_buf,
+  size_t num, int key_bits = 64)
+{
+  if (num < 2)
+    return;
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  size_t num_items = (size_t)n_wgroups * wgroup_size;
+  size_t per_item = (num + num_items - 1) / num_items;
+  buffer<uint32_t,1> digit_count_buf{range<1>(SORT_RADIX_BINS * num_items)};
+  buffer<uint64_t,1> digit_slot_buf{range<1>(SORT_RADIX_BINS * num_items)};
+  buffer<uint64_t,1> total_buf{range<1>(1)};
+
+  // an even number of passes leaves the result in keys_buf/vals_buf; a pass
+  // over an all-zero digit keeps the order
+  int passes = (key_bits + SORT_RADIX_BITS - 1) / SORT_RADIX_BITS;
+  passes += passes & 1;
+  for (int pass = 0; pass < passes; pass++) {
+    int shift = pass * SORT_RADIX_BITS;
+    buffer<uint64_t,1> &src_keys_buf = (pass & 1) ? tmp_keys_buf : keys_buf;
+    buffer<uint32_t,1> &src_vals_buf = (pass & 1) ? tmp_vals_buf : vals_buf;
+    buffer<uint64_t,1> &dst_keys_buf = (pass & 1) ? keys_buf : tmp_keys_buf;
+    buffer<uint32_t,1> &dst_vals_buf = (pass & 1) ? vals_buf : tmp_vals_buf;
+
+    event count_event = q.submit([&] (handler& h) {
+      auto src_keys = src_keys_buf.get_access<access::mode::read>(h);
+      auto count_mem = digit_count_buf.get_access<access::mode::discard_write>(h);
+
+      h.parallel_for<class radix_count_kernel>(
+        nd_range<1>(num_items, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t global_id = item.get_global_id(0);
+          size_t begin = std::min(num, global_id * per_item);
+          size_t end = std::min(num, begin + per_item);
+          // the counters of a work-item are only touched by that work-item
+          for (int d = 0; d < SORT_RADIX_BINS; d++)
+            count_mem[d * num_items + global_id] = 0;
+          for (size_t i = begin; i < end; i++)
+            count_mem[((src_keys[i] >> shift) & (SORT_RADIX_BINS - 1)) * num_items + global_id]++;
+      }); // parallel_for
+    }); // q.submit
+
+    event scan_event = submit_exclusive_scan(q, wgroup_size, digit_count_buf,
+      SORT_RADIX_BINS * num_items, digit_slot_buf, total_buf);
+
+    event scatter_event = q.submit([&] (handler& h) {
+      auto src_keys = src_keys_buf.get_access<access::mode::read>(h);
+      auto src_vals = src_vals_buf.get_access<access::mode::read>(h);
+      auto dst_keys = dst_keys_buf.get_access<access::mode::write>(h);
+      auto dst_vals = dst_vals_buf.get_access<access::mode::write>(h);
+      auto slot_mem = digit_slot_buf.get_access<access::mode::read_write>(h);
+
+      h.parallel_for<class radix_scatter_kernel>(
+        nd_range<1>(num_items, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t global_id = item.get_global_id(0);
+          size_t begin = std::min(num, global_id * per_item);
+          size_t end = std::min(num, begin + per_item);
+          for (size_t i = begin; i < end; i++) {
+            uint64_t key = src_keys[i];
+            uint64_t slot = slot_mem[((key >> shift) & (SORT_RADIX_BINS - 1)) * num_items + global_id]++;
+            dst_keys[slot] = key;
+            dst_vals[slot] = src_vals[i];
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    total_kernel_time_ns +=
+      (count_event.get_profiling_info<info::event_profiling::command_end>() -
+       count_event.get_profiling_info<info::event_profiling::command_start>()) +
+      (scan_event.get_profiling_info<info::event_profiling::command_end>() -
+       scan_event.get_profiling_info<info::event_profiling::command_start>()) +
+      (scatter_event.get_profiling_info<info::event_profiling::command_end>() -
+       scatter_event.get_profiling_info<info::event_profiling::command_start>());
+#endif
+  }
+#if FPGA || FPGA_PROFILE
+  std::cout << " Radix sort compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+}
+
+#endif
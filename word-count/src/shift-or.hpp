@@ -0,0 +1,270 @@
+//==============================================================
+// DPC++ Example
+//
+// Shift-Or (bitap) pattern search for Word Count
+//
+// A pattern is a sequence of positions, each matching a set of bytes:
+// a literal character, '?' for any byte, or a class such as [aeiou],
+// [a-z] or [^0-9]; '\' escapes the next character. Every position is one
+// bit of a 64-bit state word, and one shift, AND and OR per text byte
+// advance every pattern packed into that word at once. Patterns are packed
+// into as few words as possible, so up to 64 positions of short patterns
+// cost the same as a single one.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __SHIFT_OR_HPP__
+#define __SHIFT_OR_HPP__
+
+#include <bitset>
+#include <string>
+#include <vector>
+#include "word-count.hpp"
+
+// longest pattern, in positions; a pattern must fit in one state word
+constexpr size_t SO_MAX_PATTERN_LEN = 64;
+// state words per work-item; the masks of all words are kept in local memory
+constexpr uint32_t SO_MAX_WORDS = 4;
+constexpr uint32_t SO_MAX_PATTERNS = SO_MAX_WORDS * 64;
+
+struct ShiftOrProgram {
+  std::vector<std::string> patterns;
+  std::vector<std::vector<std::bitset<256>>> positions;  // bytes accepted at each position
+  size_t max_pattern_len = 0;
+  uint32_t num_words = 0;
+  // masks[w * 256 + c] has a 0 at every position of word w that accepts byte c
+  std::vector<uint64_t> masks;
+  std::vector<uint64_t> start_mask;    // first position of each pattern in word w
+  std::vector<uint64_t> end_mask;      // last position of each pattern in word w
+  std::vector<uint32_t> end_pattern;   // num_words * 64: pattern ending at that bit
+};
+
+//************************************
+// Parse one pattern into its byte sets; returns false on a syntax error
+//************************************
+bool parse_shift_or_pattern(const std::string &p, std::vector<std::bitset<256>> &positions) {
+  positions.clear();
+  for (size_t i = 0; i < p.size(); i++) {
+    std::bitset<256> set;
+    if (p[i] == '?') {
+      set.set();
+    } else if (p[i] == '[') {
+      size_t j = i + 1;
+      bool negate = j < p.size() && p[j] == '^';
+      if (negate)
+        j++;
+      // a ']' right after the opening bracket is a member, not the end
+      size_t first = j;
+      for (; j < p.size() && (p[j] != ']' || j == first); j++) {
+        unsigned char lo = p[j];
+        if (p[j] == '\\' && j + 1 < p.size())
+          lo = p[++j];
+        unsigned char hi = lo;
+        if (j + 2 < p.size() && p[j+1] == '-' && p[j+2] != ']') {
+          hi = p[j+2];
+          j += 2;
+        }
+        for (unsigned c = lo; c <= hi; c++)
+          set.set(c);
+      }
+      if (j == p.size())
+        return false;
+      if (negate)
+        set.flip();
+      i = j;
+    } else {
+      if (p[i] == '\\' && i + 1 < p.size())
+        i++;
+      set.set((unsigned char)p[i]);
+    }
+    positions.push_back(set);
+  }
+  return !positions.empty() && positions.size() <= SO_MAX_PATTERN_LEN;
+}
+
+//************************************
+// Compile the patterns and pack them into state words, first fit in order
+//************************************
+ShiftOrProgram build_shift_or(const std::vector<std::string> &patterns) {
+  ShiftOrProgram so;
+  so.patterns = patterns;
+  if (patterns.size() > SO_MAX_PATTERNS) {
+    std::cout << "At most " << SO_MAX_PATTERNS << " patterns are supported" << std::endl;
+    exit(1);
+  }
+
+  uint32_t used = 64;  // bits used in the current word
+  for (uint32_t p = 0; p < patterns.size(); p++) {
+    std::vector<std::bitset<256>> positions;
+    if (!parse_shift_or_pattern(patterns[p], positions)) {
+      std::cout << "Invalid pattern (or longer than " << SO_MAX_PATTERN_LEN
+                << " positions): " << patterns[p] << std::endl;
+      exit(1);
+    }
+    so.max_pattern_len = std::max(so.max_pattern_len, positions.size());
+
+    if (used + positions.size() > 64) {
+      if (so.num_words == SO_MAX_WORDS) {
+        std::cout << "The patterns need more than " << SO_MAX_WORDS * 64
+                  << " positions in total" << std::endl;
+        exit(1);
+      }
+      so.num_words++;
+      so.masks.resize(so.num_words * 256, ~0ull);
+      so.start_mask.push_back(0);
+      so.end_mask.push_back(0);
+      so.end_pattern.resize(so.num_words * 64, 0);
+      used = 0;
+    }
+    uint32_t w = so.num_words - 1;
+    for (size_t j = 0; j < positions.size(); j++)
+      for (unsigned c = 0; c < 256; c++)
+        if (positions[j].test(c))
+          so.masks[w * 256 + c] &= ~(1ull << (used + j));
+    so.start_mask[w] |= 1ull << used;
+    used += positions.size();
+    so.end_mask[w] |= 1ull << (used - 1);
+    so.end_pattern[w * 64 + used - 1] = p;
+    so.positions.push_back(positions);
+  }
+  return so;
+}
+
+//************************************
+// Shift-Or pattern count in DPC++ on device:
+//************************************
+// Work-items own chars_per_item end positions each, laid out by global id
+// as in reduction_kernel. A match ending in an item's slice may start up to
+// max_pattern_len-1 bytes earlier, so each item first runs the automaton
+// over that many preceding bytes without counting.
+void shift_or_search(queue &q, uint32_t n_wgroups, int wgroup_size, const ShiftOrProgram &so,
+  const char *text, size_t text_size, size_t chars_per_item, std::vector<uint32_t> &counts)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+  size_t num_patterns = so.patterns.size();
+  counts.assign(num_patterns, 0);
+
+  auto local_mem_size = q.get_device().get_info<info::device::local_mem_size>();
+  if (local_mem_size < so.masks.size() * sizeof(uint64_t) + num_patterns * sizeof(uint32_t))
+    throw "Device doesn't have enough local memory!";
+
+  {
+    buffer<char, 1> text_buf(text, range<1>(text_size));
+    buffer<uint64_t, 1> mask_buf(so.masks.data(), range<1>(so.masks.size()));
+    buffer<uint64_t, 1> start_buf(so.start_mask.data(), range<1>(so.num_words));
+    buffer<uint64_t, 1> end_buf(so.end_mask.data(), range<1>(so.num_words));
+    buffer<uint32_t, 1> pattern_buf(so.end_pattern.data(), range<1>(so.end_pattern.size()));
+    buffer<uint32_t, 1> count_buf(counts.data(), range<1>(num_patterns));
+
+    std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+    std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+    event e = q.submit([&] (handler& h) {
+      accessor <uint64_t, 1,
+        access::mode::read_write,
+        access::target::local>
+      local_masks(range<1>(so.masks.size()), h);
+      accessor <uint32_t, 1,
+        access::mode::read_write,
+        access::target::local>
+      local_counts(range<1>(num_patterns), h);
+
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto mask_mem = mask_buf.get_access<access::mode::read>(h);
+      auto start_mem = start_buf.get_access<access::mode::read>(h);
+      auto end_mem = end_buf.get_access<access::mode::read>(h);
+      auto pattern_mem = pattern_buf.get_access<access::mode::read>(h);
+      auto count_mem = count_buf.get_access<access::mode::read_write>(h);
+
+      auto text_max_len = text_size;
+      auto num_words = so.num_words;
+      auto num_masks = so.masks.size();
+      auto halo = so.max_pattern_len - 1;
+
+      h.parallel_for<class shift_or_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          // the masks are looked up once per byte and word, stage them in local memory
+          size_t local_id = item.get_local_id(0);
+          for (size_t m = local_id; m < num_masks; m += wgroup_size)
+            local_masks[m] = mask_mem[m];
+          for (size_t p = local_id; p < num_patterns; p += wgroup_size)
+            local_counts[p] = 0;
+          item.barrier(sycl::access::fence_space::local_space);
+
+          uint64_t start[SO_MAX_WORDS], end_bits[SO_MAX_WORDS], state[SO_MAX_WORDS];
+          for (uint32_t w = 0; w < num_words; w++) {
+            start[w] = start_mem[w];
+            end_bits[w] = end_mem[w];
+            state[w] = ~0ull;
+          }
+
+          size_t begin = item.get_global_id(0) * chars_per_item;
+          size_t end = begin + chars_per_item;
+          if (end > text_max_len)
+            end = text_max_len;
+
+          for (size_t i = (begin > halo ? begin - halo : 0); i < end; i++) {
+            unsigned char c = text_mem[i];
+            for (uint32_t w = 0; w < num_words; w++) {
+              // a 0 bit means the pattern prefix up to that position matches
+              // here; every pattern may start at every byte
+              state[w] = ((state[w] << 1) & ~start[w]) | local_masks[w * 256 + c];
+              uint64_t hits = ~state[w] & end_bits[w];
+              while (hits != 0 && i >= begin) {
+                uint32_t bit = sycl::ctz(hits);
+                local_atomic_ref<uint32_t>(local_counts[pattern_mem[w * 64 + bit]])++;
+                hits &= hits - 1;
+              }
+            }
+          }
+          item.barrier(sycl::access::fence_space::local_space);
+
+          for (size_t p = local_id; p < num_patterns; p += wgroup_size)
+            if (local_counts[p] != 0)
+              global_atomic_ref<uint32_t>(count_mem[p]) += local_counts[p];
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    // Query event e for kernel profiling information
+    // (blocks until command groups associated with e complete)
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+
+    total_kernel_time_ns += kernel_time_ns;
+
+    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // buffers copy the counts back to host here
+}
+
+//************************************
+// Pattern count on host by direct comparison, used to validate the device results
+//************************************
+void shift_or_search_host(const ShiftOrProgram &so, const char *text, size_t text_size,
+  std::vector<uint32_t> &counts)
+{
+  counts.assign(so.patterns.size(), 0);
+  for (size_t p = 0; p < so.patterns.size(); p++) {
+    const std::vector<std::bitset<256>> &pos = so.positions[p];
+    for (size_t i = 0; i + pos.size() <= text_size; i++) {
+      size_t j = 0;
+      while (j < pos.size() && pos[j].test((unsigned char)text[i + j]))
+        j++;
+      if (j == pos.size())
+        counts[p]++;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,503 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: search kernel for the four-character keywords
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __STRING_SEARCH_HPP__
+#define __STRING_SEARCH_HPP__
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "word-count.hpp"
+#include "host-search.hpp"
+
+// how the text is divided among the work-items of the search kernel
+enum Partition {
+  CONTIGUOUS,   // one slice of chars_per_item bytes per work-item
+  INTERLEAVED   // SEGMENT_SIZE-byte segments dealt out round-robin
+};
+constexpr size_t SEGMENT_SIZE = 64;
+
+const char *partition_name(Partition p) {
+  return p == INTERLEAVED ? "interleaved" : "contiguous";
+}
+
+// events of the search kernel and of the reduction of its per-group counters
+struct SearchEvents {
+  event search;
+  event reduce;
+};
+
+double kernel_time_ns(const SearchEvents &e) {
+  return (e.search.get_profiling_info<info::event_profiling::command_end>() -
+          e.search.get_profiling_info<info::event_profiling::command_start>()) +
+         (e.reduce.get_profiling_info<info::event_profiling::command_end>() -
+          e.reduce.get_profiling_info<info::event_profiling::command_start>());
+}
+
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+// FPGA kernels are compiled ahead of time, there is nothing to specialize
+// at run time and an extra kernel would only cost area
+#define HAVE_BAKED_SEARCH 0
+#else
+#define HAVE_BAKED_SEARCH 1
+#endif
+
+#if HAVE_BAKED_SEARCH
+// the keywords baked into the specialized search kernel, each as the
+// little-endian 32-bit word of its four bytes
+struct BakedKeywords {
+  uint32_t word[NUM_KEYWORDS];
+};
+constexpr specialization_id<BakedKeywords> baked_keywords_id;
+class baked_search_kernel;
+
+inline uint32_t keyword_word(const char4 &k) {
+  return (uint32_t)(unsigned char)k.x() | (uint32_t)(unsigned char)k.y() << 8 |
+         (uint32_t)(unsigned char)k.z() << 16 | (uint32_t)(unsigned char)k.w() << 24;
+}
+
+// search kernels specialized for a keyword set, each built for one device
+// of one context
+struct BakedSearchBundle {
+  context ctx;
+  device dev;
+  std::array<uint32_t, NUM_KEYWORDS> words;
+  kernel_bundle<bundle_state::executable> bundle;
+};
+
+//************************************
+// The built specialized search kernels, reused for the rest of the run
+//************************************
+// The owner keeps the cache alive for as long as it submits baked searches
+// and must release it before the end of main(), while the SYCL runtime
+// that the kernel bundles belong to is still up.
+struct BakedSearchCache {
+  std::vector<BakedSearchBundle> bundles;
+};
+
+//************************************
+// The search kernel specialized for the keywords in baked on the device of
+// q, JIT-compiled on first use and then taken from cache
+//************************************
+// With the keywords as specialization constants, the JIT compiler sees
+// them as immediates and the compares unroll into constant compares.
+kernel_bundle<bundle_state::executable> &baked_search_bundle(queue &q,
+  const BakedKeywords &baked, BakedSearchCache &cache)
+{
+  std::array<uint32_t, NUM_KEYWORDS> words;
+  std::copy(baked.word, baked.word + NUM_KEYWORDS, words.begin());
+  context ctx = q.get_context();
+  device dev = q.get_device();
+  for (auto &b : cache.bundles)
+    if (b.ctx == ctx && b.dev == dev && b.words == words)
+      return b.bundle;
+
+  dpc_common::TimeInterval build_time;
+  auto input = get_kernel_bundle<bundle_state::input>(ctx, std::vector<device>{dev},
+    std::vector<kernel_id>{get_kernel_id<baked_search_kernel>()});
+  input.set_specialization_constant<baked_keywords_id>(baked);
+  cache.bundles.push_back(BakedSearchBundle{ctx, dev, words, build(input)});
+  std::cout << "specialized search kernel built in " << build_time.Elapsed() * 1000
+            << " ms" << std::endl;
+  return cache.bundles.back().bundle;
+}
+#else
+// nothing to cache without the specialized search kernel
+struct BakedSearchCache {};
+#endif
+
+//************************************
+// Sum the per-group counters of group_result_buf into global_result_buf
+//************************************
+event submit_group_reduction(queue &q, uint32_t n_wgroups, int wgroup_size,
+  buffer<uint32_t,1> &group_result_buf, buffer<uint32_t,1> &global_result_buf)
+{
+  // one work-group sums the per-group counters
+  return q.submit([&] (handler& h) {
+    auto group_mem = group_result_buf.get_access<access::mode::read>(h);
+    auto global_mem = global_result_buf.get_access<access::mode::read_write>(h);
+
+    h.parallel_for<class group_reduction_kernel>(
+      nd_range<1>(wgroup_size, wgroup_size),
+      [=] (nd_item<1> item)
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+      REQD_SUB_GROUP_SIZE
+      {
+        size_t local_id = item.get_local_id(0);
+
+        // each work-item adds up a strided subset of the work-groups' rows
+        uint32_t sum[NUM_KEYWORDS] = {0};
+        for (size_t g = local_id; g < n_wgroups; g += wgroup_size)
+          for(int k = 0; k < NUM_KEYWORDS ; k++)
+            sum[k] += group_mem[g * NUM_KEYWORDS + k];
+        for(int k = 0; k < NUM_KEYWORDS ; k++) {
+          uint32_t total = reduce_over_group(item.get_group(), sum[k], sycl::plus<uint32_t>());
+          if (local_id == 0)
+            global_mem[k] += total;
+        }
+    }); // parallel_for
+  }); // q.submit
+}
+
+//************************************
+// Submit the word count kernels for text_len characters in text_buf,
+// adding the keyword counts to global_result_buf
+//************************************
+// The counters are reduced hierarchically without atomics: work-items
+// count in private registers, each work-group reduces them with
+// reduce_over_group and writes the sums to its own row of group_result_buf
+// (n_wgroups * NUM_KEYWORDS), and a second kernel sums the rows into
+// global_result_buf.
+//
+// With INTERLEAVED partitioning, work-item g scans the SEGMENT_SIZE-byte
+// segments g, g + N, g + 2N, ... (N work-items in total), so neighbouring
+// work-items read neighbouring segments at the same time. As with the
+// contiguous slices, a work-item counts the keywords *starting* in its
+// segments and reads up to KEYWORD_LEN-1 bytes past a segment's end, so a
+// keyword crossing a segment boundary is counted exactly once.
+//
+// With baked set (CPU and GPU only), the search kernel specialized for the
+// keywords is used instead, built once and then reused from baked; it
+// slides a 32-bit window over the text, one byte load per position, and
+// compares it with the baked keyword words.
+SearchEvents submit_string_search(queue &q, buffer<char,1> &text_buf, size_t text_len,
+  uint32_t n_wgroups, int wgroup_size, const std::vector<char4> &pattern,
+  size_t chars_per_item, buffer<uint32_t,1> &group_result_buf,
+  buffer<uint32_t,1> &global_result_buf, Partition partition = CONTIGUOUS,
+  BakedSearchCache *baked = NULL)
+{
+  const bool interleaved = partition == INTERLEAVED;
+  const size_t segment_stride = (size_t)n_wgroups * wgroup_size * SEGMENT_SIZE;
+  SearchEvents e;
+  char4 keywords[NUM_KEYWORDS];
+  for(int k = 0; k < NUM_KEYWORDS ; k++){
+    keywords[k] = pattern[k];
+  }
+
+#if HAVE_BAKED_SEARCH
+  if (baked) {
+    BakedKeywords baked_keywords;
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      baked_keywords.word[k] = keyword_word(pattern[k]);
+    auto &bundle = baked_search_bundle(q, baked_keywords, *baked);
+
+    e.search = q.submit([&] (handler& h) {
+      auto group_mem = group_result_buf.get_access<access::mode::discard_write>(h);
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto text_max_len = text_len;
+      h.use_kernel_bundle(bundle);
+
+      h.parallel_for<baked_search_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item, kernel_handler kh)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        REQD_SUB_GROUP_SIZE
+        {
+          const BakedKeywords keyword = kh.get_specialization_constant<baked_keywords_id>();
+          uint32_t count[NUM_KEYWORDS] = {0};
+          auto byte_at = [&](size_t i) { return (uint32_t)(unsigned char)text_mem[i]; };
+
+          // count the keywords starting at positions [begin, end)
+          auto scan = [&](size_t begin, size_t end) {
+            if (text_max_len < KEYWORD_LEN)
+              return;
+            end = std::min(end, text_max_len - KEYWORD_LEN + 1);
+            if (begin >= end)
+              return;
+            // bytes i, i+1 and i+2 of the window starting at i
+            uint32_t word = byte_at(begin) | byte_at(begin + 1) << 8 | byte_at(begin + 2) << 16;
+            for (size_t i = begin; i < end; i++) {
+              uint32_t window = word | byte_at(i + 3) << 24;
+              for (int k = 0; k < NUM_KEYWORDS; k++)
+                count[k] += window == keyword.word[k];
+              word = window >> 8;
+            }
+          };
+
+          if (interleaved) {
+            for (size_t seg = item.get_global_id(0) * SEGMENT_SIZE; seg < text_max_len;
+                 seg += segment_stride)
+              scan(seg, seg + SEGMENT_SIZE);
+          } else {
+            size_t item_offset = item.get_global_id(0) * chars_per_item;
+            scan(item_offset, item_offset + chars_per_item);
+          }
+
+          size_t group_id = item.get_group(0);
+          for (int k = 0; k < NUM_KEYWORDS; k++) {
+            uint32_t group_count = reduce_over_group(item.get_group(), count[k], sycl::plus<uint32_t>());
+            if (item.get_local_id(0) == 0)
+              group_mem[group_id * NUM_KEYWORDS + k] = group_count;
+          }
+      }); // parallel_for
+    }); // q.submit
+
+    e.reduce = submit_group_reduction(q, n_wgroups, wgroup_size, group_result_buf,
+      global_result_buf);
+    return e;
+  }
+#endif
+
+  e.search = q.submit([&] (handler& h) {
+    // point to global memory where the counters of each work-group are stored
+    auto group_mem = group_result_buf.get_access<access::mode::discard_write>(h);
+
+    // point to global memory where the text are stored
+    auto text_mem = text_buf.get_access<access::mode::read>(h);
+    auto text_max_len = text_len;
+    // use nd_range to specify kernels' global size and local size.
+    // in this case, we use one-dimensional nd_range
+    // the first range object specifies the number of (total) work items per dimension
+    // the second range object specifies the number of work items in a work group
+    h.parallel_for<class reduction_kernel>(
+      nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+      [=] (nd_item<1> item)
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+      // the FPGA compiler vectorizes the kernel for one fixed work-group size
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE),
+        sycl::reqd_work_group_size(1,1,MAX_WG_SIZE),
+        intel::num_simd_work_items(SIMD_WORK_ITEMS)]]
+#else
+      // CPU and GPU devices take any work-group size up to MAX_WG_SIZE
+      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+#endif
+      REQD_SUB_GROUP_SIZE
+      {
+        // private counters: a match costs a register increment instead of
+        // an atomic on local memory shared by the whole work-group
+        uint32_t count[NUM_KEYWORDS] = {0};
+
+        // count the keywords starting at positions [begin, end)
+        auto scan = [&](size_t begin, size_t end) {
+          /* Iterate through characters in text */
+          for(size_t i=begin; i<end; i++) {
+            // check bounds of text buffer
+            if(i + KEYWORD_LEN > text_max_len)
+              break;
+            //load one four-character word
+            char4 text_word;
+            text_word.load(0, text_mem.get_pointer()+i);
+            for(int k = 0; k < NUM_KEYWORDS ; k++){
+              if (text_word.x() == keywords[k].x() &&
+                  text_word.y() == keywords[k].y() &&
+                  text_word.z() == keywords[k].z() &&
+                  text_word.w() == keywords[k].w()
+                )
+              {
+                count[k]++;
+              }
+            }
+          }
+        };
+
+        if (interleaved) {
+          for (size_t seg = item.get_global_id(0) * SEGMENT_SIZE; seg < text_max_len;
+               seg += segment_stride)
+            scan(seg, seg + SEGMENT_SIZE);
+        } else {
+          // Each work item will process char_per_item characters; the slices
+          // are laid out by global id so that every work-group scans its own
+          // part of the text
+          size_t item_offset = item.get_global_id(0) * chars_per_item;
+          scan(item_offset, item_offset + chars_per_item);
+        }
+
+        // combine the private counters of the work-group; the runtime
+        // reduces within each sub-group first, then across sub-groups
+        size_t group_id = item.get_group(0);
+        for(int k = 0; k < NUM_KEYWORDS ; k++) {
+          uint32_t group_count = reduce_over_group(item.get_group(), count[k], sycl::plus<uint32_t>());
+          if (item.get_local_id(0) == 0)
+            group_mem[group_id * NUM_KEYWORDS + k] = group_count;
+        }
+
+    }); // parallel_for
+  }); // q.submit
+
+  e.reduce = submit_group_reduction(q, n_wgroups, wgroup_size, group_result_buf,
+    global_result_buf);
+
+  return e;
+}
+
+//************************************
+// Word Count in DPC++ on device:
+//************************************
+// With use_host_ptr, the text buffer is told to use the host memory in
+// place rather than allocate a copy of its own. For a memory mapped file
+// on a CPU device the kernel then reads the page cache directly; other
+// devices still get exactly one host-to-device transfer.
+void string_search(queue &q, uint32_t total_num_workitems, uint32_t n_wgroups,
+  int wgroup_size, std::vector<char4> pattern, const char* text, size_t text_size,
+  size_t chars_per_item, uint32_t* global_result, bool use_host_ptr = false,
+  Partition partition = CONTIGUOUS, BakedSearchCache *baked = NULL)
+{
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+
+  // buffers for device
+  buffer<char,1> text_buf = use_host_ptr
+    ? buffer<char,1>(text, range<1>(text_size), property_list{property::buffer::use_host_ptr()})
+    : buffer<char,1>(text, range<1>(text_size));
+  buffer<uint32_t, 1> group_result_buf{range<1>(n_wgroups * NUM_KEYWORDS)};
+  buffer<uint32_t, 1> global_result_buf(global_result, range<1>(NUM_KEYWORDS));
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  dpc_common::TimeInterval search_time;
+  SearchEvents e = submit_string_search(q, text_buf, text_size, n_wgroups, wgroup_size,
+    pattern, chars_per_item, group_result_buf, global_result_buf, partition, baked);
+  q.wait();
+  // without kernel profiling the time includes the copy of the text to the device
+  double search_time_s = search_time.Elapsed();
+#if FPGA || FPGA_PROFILE
+    // Query the events for kernel profiling information
+    // (blocks until command groups associated with them complete)
+    total_kernel_time_ns += kernel_time_ns(e);
+    search_time_s = total_kernel_time_ns * 1e-9;
+
+    // Report profiling info as it takes multiple steps
+    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  std::cout << partition_name(partition) << " partitioning: " << search_time_s * 1000
+            << " ms (" << text_size / search_time_s * 1e-9 << " GB/s)\n";
+}
+
+//************************************
+// Word Count in DPC++ on device, streaming the text in chunks:
+//************************************
+// The file is read chunk_size bytes at a time into one of two staging slots.
+// Each chunk is prefixed with the last KEYWORD_LEN-1 bytes of the previous
+// one (the halo), so a keyword straddling a chunk boundary is seen whole by
+// exactly one kernel: a chunk counts the keywords *starting* anywhere in its
+// halo or body that also end inside it. While the kernel on one slot runs,
+// the host reads the next chunk into the other slot; a slot is recycled
+// only after the kernel that used it is retired.
+void stream_search(queue &q, uint32_t n_wgroups, int wgroup_size,
+  std::vector<char4> pattern, FILE *text_handle, size_t text_size,
+  size_t chunk_size, uint32_t* global_result, Partition partition = CONTIGUOUS,
+  BakedSearchCache *baked = NULL)
+{
+  constexpr int NUM_SLOTS = 2;
+  constexpr size_t halo = KEYWORD_LEN - 1;
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+#endif
+
+  std::vector<char> slot_text[NUM_SLOTS];
+  uint32_t slot_result[NUM_SLOTS][NUM_KEYWORDS];
+  std::unique_ptr<buffer<char,1>> slot_text_buf[NUM_SLOTS];
+  std::unique_ptr<buffer<uint32_t,1>> slot_group_buf[NUM_SLOTS];
+  std::unique_ptr<buffer<uint32_t,1>> slot_result_buf[NUM_SLOTS];
+  SearchEvents slot_event[NUM_SLOTS];
+  for (int s = 0; s < NUM_SLOTS; s++) {
+    slot_text[s].resize(chunk_size + halo);
+    std::fill(slot_result[s], slot_result[s] + NUM_KEYWORDS, 0);
+  }
+
+  // wait for the kernel in slot s (if any) and fold its counters into the total
+  auto retire = [&](int s) {
+    if (!slot_text_buf[s])
+      return;
+#if FPGA || FPGA_PROFILE
+    total_kernel_time_ns += kernel_time_ns(slot_event[s]);
+#endif
+    // destroying the buffers waits for the kernel and copies the counters back
+    slot_text_buf[s].reset();
+    slot_result_buf[s].reset();
+    slot_group_buf[s].reset();
+    for (int k = 0; k < NUM_KEYWORDS; k++) {
+      global_result[k] += slot_result[s][k];
+      slot_result[s][k] = 0;
+    }
+  };
+
+  size_t total_num_workitems = (size_t)n_wgroups * wgroup_size;
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+  std::cout << "chunk_size = " << chunk_size << " bytes, chars_per_item = "
+            << (chunk_size + halo + total_num_workitems - 1)/total_num_workitems << std::endl;
+
+  dpc_common::TimeInterval stream_time;
+  char tail[halo];
+  size_t carry = 0, offset = 0, num_chunks = 0;
+  while (offset < text_size) {
+    int s = num_chunks % NUM_SLOTS;
+    retire(s);
+
+    char *chunk = slot_text[s].data();
+    memcpy(chunk, tail, carry);
+    size_t want = std::min(chunk_size, text_size - offset);
+    size_t got = fread(chunk + carry, sizeof(char), want, text_handle);
+    if (got != want) {
+      perror("Couldn't read the text file");
+      exit(1);
+    }
+    size_t chunk_len = carry + got;
+    offset += got;
+    num_chunks++;
+
+    // the last bytes of this chunk become the halo of the next one
+    carry = std::min(halo, chunk_len);
+    memcpy(tail, chunk + chunk_len - carry, carry);
+
+    if (chunk_len < KEYWORD_LEN)
+      continue;
+
+    size_t chars_per_item = (chunk_len + total_num_workitems - 1)/total_num_workitems;
+    slot_text_buf[s].reset(new buffer<char,1>(chunk, range<1>(chunk_len)));
+    slot_group_buf[s].reset(new buffer<uint32_t,1>(range<1>(n_wgroups * NUM_KEYWORDS)));
+    slot_result_buf[s].reset(new buffer<uint32_t,1>(slot_result[s], range<1>(NUM_KEYWORDS)));
+    slot_event[s] = submit_string_search(q, *slot_text_buf[s], chunk_len, n_wgroups,
+      wgroup_size, pattern, chars_per_item, *slot_group_buf[s], *slot_result_buf[s], partition,
+      baked);
+  }
+  for (int s = 0; s < NUM_SLOTS; s++)
+    retire(s);
+
+  double stream_time_s = stream_time.Elapsed();
+  std::cout << "streamed " << num_chunks << " chunks in " << stream_time_s * 1000 << " ms ("
+            << text_size / stream_time_s * 1e-9 << " GB/s, " << partition_name(partition)
+            << " partitioning)\n";
+#if FPGA || FPGA_PROFILE
+  std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+}
+
+//************************************
+// Word Count on host over a streamed file, with the same halo as stream_search
+//************************************
+void stream_count_host(const std::vector<char4> &pattern, FILE *text_handle,
+  size_t text_size, size_t chunk_size, uint32_t *host_result)
+{
+  constexpr size_t halo = KEYWORD_LEN - 1;
+  std::vector<char> chunk(chunk_size + halo);
+  size_t carry = 0, offset = 0;
+  while (offset < text_size) {
+    size_t got = fread(chunk.data() + carry, sizeof(char),
+      std::min(chunk_size, text_size - offset), text_handle);
+    if (got == 0)
+      break;
+    size_t chunk_len = carry + got;
+    offset += got;
+    count_keywords_host(pattern, chunk.data(), chunk_len, host_result);
+    carry = std::min(halo, chunk_len);
+    memmove(chunk.data(), chunk.data() + chunk_len - carry, carry);
+  }
+}
+
+#endif
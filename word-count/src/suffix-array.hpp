@@ -0,0 +1,397 @@
+//==============================================================
+// DPC++ Example
+//
+// Suffix array index for Word Count
+//
+// The suffix array of the text lists the start of every suffix in sorted
+// order, so all occurrences of a substring are adjacent in it and their
+// number is found with two binary searches, O(m log n) for a substring of
+// m bytes, instead of a scan of the whole text. The array is built once on
+// device by prefix doubling and saved next to the text file, from where it
+// is memory mapped for later queries.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __SUFFIX_ARRAY_HPP__
+#define __SUFFIX_ARRAY_HPP__
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "word-count.hpp"
+#include "mapped-file.hpp"
+#include "prefix-sum.hpp"
+#include "radix-sort.hpp"
+
+// the index is the text file's name with this suffix
+#define SUFFIX_INDEX_EXT ".sa"
+
+// file layout: this header, then text_size uint32_t suffix starts
+struct SuffixIndexHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t text_size;
+};
+constexpr char SUFFIX_INDEX_MAGIC[4] = {'W', 'C', 'S', 'A'};
+constexpr uint32_t SUFFIX_INDEX_VERSION = 1;
+
+struct SuffixIndex {
+  MappedFile file;
+  const uint32_t *sa = NULL;
+  size_t text_size = 0;
+};
+
+inline std::string suffix_index_path(const char *text_file) {
+  return std::string(text_file) + SUFFIX_INDEX_EXT;
+}
+
+// number of bits needed to store the values 0 .. max_value
+inline int bit_width(uint64_t max_value) {
+  int bits = 1;
+  while (bits < 64 && (max_value >> bits) != 0)
+    bits++;
+  return bits;
+}
+
+//************************************
+// Build the suffix array of the text in DPC++ on device:
+//************************************
+// Prefix doubling: after the round for k, rank[i] orders the suffixes by
+// their first 2k bytes. Each round sorts the suffixes by the pair
+// (rank[i], rank[i+k]), packed into one key of twice the rank width, and
+// renumbers them: a suffix whose key differs from its predecessor's starts
+// a new rank. The array is done once all ranks are distinct, after at most
+// log2(n) rounds.
+void build_suffix_array(queue &q, uint32_t n_wgroups, int wgroup_size, const char *text,
+  size_t text_size, std::vector<uint32_t> &sa)
+{
+  if (text_size >= UINT32_MAX) {
+    std::cout << "The suffix array index supports texts of up to 4 GB" << std::endl;
+    exit(1);
+  }
+#if FPGA || FPGA_PROFILE
+  double total_kernel_time_ns = 0;
+  auto kernel_time = [](event &e) {
+    return e.get_profiling_info<info::event_profiling::command_end>() -
+           e.get_profiling_info<info::event_profiling::command_start>();
+  };
+#endif
+  size_t num = text_size;
+  size_t num_items = (size_t)n_wgroups * wgroup_size;
+  size_t per_item = (num + num_items - 1) / num_items;
+  sa.resize(num);
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  {
+    buffer<char,1> text_buf(text, range<1>(text_size));
+    buffer<uint32_t,1> rank_buf{range<1>(num)};
+    buffer<uint64_t,1> keys_buf{range<1>(num)};
+    buffer<uint32_t,1> vals_buf(sa.data(), range<1>(num));
+    buffer<uint64_t,1> tmp_keys_buf{range<1>(num)};
+    buffer<uint32_t,1> tmp_vals_buf{range<1>(num)};
+    buffer<uint32_t,1> item_count_buf{range<1>(num_items)};
+    buffer<uint64_t,1> item_slot_buf{range<1>(num_items)};
+    buffer<uint64_t,1> total_buf{range<1>(1)};
+
+    // rank 0 is the end of the text, so a suffix sorts before its extensions
+    event init_event = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto rank = rank_buf.get_access<access::mode::discard_write>(h);
+
+      h.parallel_for<class sa_init_kernel>(
+        nd_range<1>(num_items, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          for (size_t i = item.get_global_id(0); i < num; i += num_items)
+            rank[i] = (unsigned char)text_mem[i] + 1;
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    total_kernel_time_ns += kernel_time(init_event);
+#endif
+
+    int rank_bits = bit_width(256);
+    for (size_t k = 1; ; k *= 2) {
+      event key_event = q.submit([&] (handler& h) {
+        auto rank = rank_buf.get_access<access::mode::read>(h);
+        auto keys = keys_buf.get_access<access::mode::discard_write>(h);
+        auto vals = vals_buf.get_access<access::mode::discard_write>(h);
+
+        h.parallel_for<class sa_key_kernel>(
+          nd_range<1>(num_items, wgroup_size),
+          [=] (nd_item<1> item)
+          [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+          {
+            for (size_t i = item.get_global_id(0); i < num; i += num_items) {
+              keys[i] = ((uint64_t)rank[i] << rank_bits) | (i + k < num ? rank[i + k] : 0);
+              vals[i] = i;
+            }
+        }); // parallel_for
+      }); // q.submit
+
+      radix_sort_pairs(q, n_wgroups, wgroup_size, keys_buf, vals_buf, tmp_keys_buf, tmp_vals_buf,
+        num, 2 * rank_bits);
+
+      // every work-item counts the new ranks starting in its block of the
+      // sorted keys ...
+      event head_count_event = q.submit([&] (handler& h) {
+        auto keys = keys_buf.get_access<access::mode::read>(h);
+        auto count_mem = item_count_buf.get_access<access::mode::discard_write>(h);
+
+        h.parallel_for<class sa_head_count_kernel>(
+          nd_range<1>(num_items, wgroup_size),
+          [=] (nd_item<1> item)
+          [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+          {
+            size_t global_id = item.get_global_id(0);
+            size_t begin = std::min(num, global_id * per_item);
+            size_t end = std::min(num, begin + per_item);
+            uint32_t count = 0;
+            for (size_t i = begin; i < end; i++)
+              if (i == 0 || keys[i] != keys[i - 1])
+                count++;
+            count_mem[global_id] = count;
+        }); // parallel_for
+      }); // q.submit
+
+      event head_scan_event = submit_exclusive_scan(q, wgroup_size, item_count_buf, num_items,
+        item_slot_buf, total_buf);
+
+      // ... and, from the number of ranks before its block, renumbers them
+      event rank_event = q.submit([&] (handler& h) {
+        auto keys = keys_buf.get_access<access::mode::read>(h);
+        auto vals = vals_buf.get_access<access::mode::read>(h);
+        auto slot_mem = item_slot_buf.get_access<access::mode::read>(h);
+        auto rank = rank_buf.get_access<access::mode::write>(h);
+
+        h.parallel_for<class sa_rank_kernel>(
+          nd_range<1>(num_items, wgroup_size),
+          [=] (nd_item<1> item)
+          [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+          {
+            size_t global_id = item.get_global_id(0);
+            size_t begin = std::min(num, global_id * per_item);
+            size_t end = std::min(num, begin + per_item);
+            uint32_t r = slot_mem[global_id];
+            for (size_t i = begin; i < end; i++) {
+              if (i == 0 || keys[i] != keys[i - 1])
+                r++;
+              rank[vals[i]] = r;
+            }
+        }); // parallel_for
+      }); // q.submit
+
+      uint64_t num_ranks = scan_total(total_buf);
+#if FPGA || FPGA_PROFILE
+      total_kernel_time_ns += kernel_time(key_event) + kernel_time(head_count_event) +
+        kernel_time(head_scan_event) + kernel_time(rank_event);
+#endif
+      std::cout << "prefix length " << 2 * k << ": " << num_ranks << " distinct ranks" << std::endl;
+      if (num_ranks == num || k >= num)
+        break;
+      rank_bits = bit_width(num_ranks);
+    }
+#if FPGA || FPGA_PROFILE
+    std::cout << " Rank kernels compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // vals_buf copies the suffix array back to host here
+}
+
+//************************************
+// Write the suffix array next to the text file
+//************************************
+void save_suffix_index(const std::string &path, const std::vector<uint32_t> &sa) {
+  FILE *index_handle = fopen(path.c_str(), "wb");
+  if (index_handle == NULL) {
+    perror("Couldn't create the index file");
+    exit(1);
+  }
+  SuffixIndexHeader header;
+  memcpy(header.magic, SUFFIX_INDEX_MAGIC, sizeof(header.magic));
+  header.version = SUFFIX_INDEX_VERSION;
+  header.text_size = sa.size();
+  if (fwrite(&header, sizeof(header), 1, index_handle) != 1 ||
+      fwrite(sa.data(), sizeof(uint32_t), sa.size(), index_handle) != sa.size()) {
+    perror("Couldn't write the index file");
+    exit(1);
+  }
+  fclose(index_handle);
+}
+
+//************************************
+// Map a suffix array saved by save_suffix_index for a text of text_size bytes
+//************************************
+SuffixIndex load_suffix_index(const std::string &path, size_t text_size) {
+  FILE *index_handle = fopen(path.c_str(), "rb");
+  if (index_handle == NULL) {
+    perror("Couldn't find the index file (build it with -b)");
+    exit(1);
+  }
+  fclose(index_handle);
+
+  SuffixIndex index;
+  index.file = map_text_file(path.c_str());
+  const SuffixIndexHeader *header = (const SuffixIndexHeader *)index.file.data;
+  if (index.file.size < sizeof(SuffixIndexHeader) ||
+      memcmp(header->magic, SUFFIX_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != SUFFIX_INDEX_VERSION ||
+      index.file.size != sizeof(SuffixIndexHeader) + header->text_size * sizeof(uint32_t)) {
+    std::cout << path << " is not a suffix array index" << std::endl;
+    exit(1);
+  }
+  if (header->text_size != text_size) {
+    std::cout << path << " was built for another version of the text, rebuild it with -b"
+              << std::endl;
+    exit(1);
+  }
+  index.sa = (const uint32_t *)(index.file.data + sizeof(SuffixIndexHeader));
+  index.text_size = text_size;
+  return index;
+}
+
+// compare the suffix at p with the m bytes of query; a suffix that is a
+// proper prefix of the query is smaller
+template <typename TextAccessor, typename QueryAccessor>
+inline int compare_suffix(const TextAccessor &text, size_t text_size, size_t p,
+  const QueryAccessor &query, size_t query_offset, size_t m)
+{
+  for (size_t t = 0; t < m; t++) {
+    if (p + t >= text_size)
+      return -1;
+    unsigned char a = text[p + t], b = query[query_offset + t];
+    if (a != b)
+      return a < b ? -1 : 1;
+  }
+  return 0;
+}
+
+//************************************
+// Count the occurrences of a batch of substrings with the suffix array in
+// DPC++ on device:
+//************************************
+// Every work-item answers whole queries: one binary search for the first
+// suffix not below the query and one for the first suffix above it.
+void suffix_index_search(queue &q, uint32_t n_wgroups, int wgroup_size,
+  const SuffixIndex &index, const char *text, const std::vector<std::string> &queries,
+  std::vector<uint32_t> &counts)
+{
+  size_t num_queries = queries.size();
+  counts.assign(num_queries, 0);
+  std::string query_chars;
+  std::vector<uint32_t> query_offsets(num_queries), query_lens(num_queries);
+  for (size_t w = 0; w < num_queries; w++) {
+    query_offsets[w] = query_chars.size();
+    query_lens[w] = queries[w].size();
+    query_chars += queries[w];
+  }
+  size_t num_items = (size_t)n_wgroups * wgroup_size;
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  {
+    size_t text_size = index.text_size;
+    buffer<char,1> text_buf(text, range<1>(text_size));
+    buffer<uint32_t,1> sa_buf(index.sa, range<1>(text_size));
+    buffer<char,1> query_buf(query_chars.data(), range<1>(query_chars.size()));
+    buffer<uint32_t,1> offset_buf(query_offsets.data(), range<1>(num_queries));
+    buffer<uint32_t,1> len_buf(query_lens.data(), range<1>(num_queries));
+    buffer<uint32_t,1> count_buf(counts.data(), range<1>(num_queries));
+
+    event e = q.submit([&] (handler& h) {
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto sa = sa_buf.get_access<access::mode::read>(h);
+      auto query_mem = query_buf.get_access<access::mode::read>(h);
+      auto offset_mem = offset_buf.get_access<access::mode::read>(h);
+      auto len_mem = len_buf.get_access<access::mode::read>(h);
+      auto count_mem = count_buf.get_access<access::mode::discard_write>(h);
+
+      h.parallel_for<class sa_query_kernel>(
+        nd_range<1>(num_items, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          for (size_t w = item.get_global_id(0); w < num_queries; w += num_items) {
+            size_t offset = offset_mem[w], m = len_mem[w];
+            // first suffix >= query
+            size_t lo = 0, hi = text_size;
+            while (lo < hi) {
+              size_t mid = lo + (hi - lo) / 2;
+              if (compare_suffix(text_mem, text_size, sa[mid], query_mem, offset, m) < 0)
+                lo = mid + 1;
+              else
+                hi = mid;
+            }
+            size_t first = lo;
+            // first suffix > query
+            hi = text_size;
+            while (lo < hi) {
+              size_t mid = lo + (hi - lo) / 2;
+              if (compare_suffix(text_mem, text_size, sa[mid], query_mem, offset, m) <= 0)
+                lo = mid + 1;
+              else
+                hi = mid;
+            }
+            count_mem[w] = lo - first;
+          }
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+    std::cout << " Total Kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  } // count_buf copies the counts back to host here
+}
+
+//************************************
+// Check on host that the suffix array lists every suffix in sorted order
+//************************************
+bool check_suffix_array(const char *text, size_t text_size, const std::vector<uint32_t> &sa) {
+  if (sa.size() != text_size)
+    return false;
+  std::vector<bool> seen(text_size, false);
+  for (size_t j = 0; j < text_size; j++) {
+    if (sa[j] >= text_size || seen[sa[j]])
+      return false;
+    seen[sa[j]] = true;
+    if (j == 0)
+      continue;
+    size_t a = sa[j - 1], b = sa[j];
+    size_t len = std::min(text_size - a, text_size - b);
+    int c = memcmp(text + a, text + b, len);
+    if (c > 0 || (c == 0 && text_size - a > text_size - b))
+      return false;
+  }
+  return true;
+}
+
+//************************************
+// Substring counts on host by scanning the text, used to validate the
+// index results
+//************************************
+void substring_count_host(const char *text, size_t text_size,
+  const std::vector<std::string> &queries, std::vector<uint32_t> &counts)
+{
+  counts.assign(queries.size(), 0);
+  for (size_t w = 0; w < queries.size(); w++) {
+    const std::string &query = queries[w];
+    const char *p = text, *end = text + text_size;
+    while ((p = std::search(p, end, query.begin(), query.end())) != end) {
+      counts[w]++;
+      p++;
+    }
+  }
+}
+
+#endif
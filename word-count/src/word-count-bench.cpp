@@ -0,0 +1,296 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: parameter sweep benchmark
+//
+// Runs the string_search kernels over a grid of corpus sizes, work-group
+// sizes, numbers of work-groups, chars per work-item and partitionings.
+// Every point is repeated, and the median and 95th percentile of the
+// kernel time (from the profiling events of the search and reduction
+// kernels) are reported as JSON or CSV together with the bandwidth.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+//
+// usage: word-count-bench [-s sizes] [-w wg_sizes] [-g groups] [-c chars_per_item]
+//                         [-r repeats] [-f json|csv] [-o report_file]
+//   -s : corpus sizes to generate, e.g. 1M,16M,256M (K/M/G suffixes allowed)
+//   -w : work-group sizes, at most MAX_WG_SIZE (exactly MAX_WG_SIZE on FPGA)
+//   -g : numbers of work-groups; chars_per_item is derived to cover the corpus
+//   -c : chars per work-item; the number of work-groups is derived
+//   -r : timed runs per configuration, after one warm-up run
+//   -f : report format
+//   -o : write the report to report_file instead of stdout
+// The lists are comma separated. Work-group sizes default to the powers of
+// two from 4 to MAX_WG_SIZE, numbers of work-groups to 1, the number of
+// compute units and four times that.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "word-count.hpp"
+#include "string-search.hpp"
+
+struct BenchPoint {
+  size_t corpus_size;
+  int wgroup_size;
+  uint32_t n_wgroups;
+  size_t chars_per_item;
+  Partition partition;
+  double median_ns;
+  double p95_ns;
+  bool wall_clock;  // the device gave no profiling info, host time was used
+  bool valid;
+};
+
+std::vector<size_t> parse_list(const char *arg) {
+  std::vector<size_t> values;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      values.push_back(parse_size(item.c_str()));
+  return values;
+}
+
+//************************************
+// Generate corpus_size bytes of text: random words from a small vocabulary
+// that includes the four keywords, so that every kernel run finds matches
+//************************************
+std::vector<char> generate_corpus(size_t corpus_size) {
+  static const char *words[] = {
+    "that", "with", "have", "from", "the", "and", "was", "his", "had", "to",
+    "of", "in", "he", "it", "her", "not", "but", "room", "door", "sister",
+    "father", "mother", "Gregor", "could", "would", "been", "which", "into"
+  };
+  const size_t num_words = sizeof(words) / sizeof(words[0]);
+  std::mt19937 rng(2021);
+  std::vector<char> text;
+  text.reserve(corpus_size + 16);
+  size_t line = 0;
+  while (text.size() < corpus_size) {
+    const char *w = words[rng() % num_words];
+    text.insert(text.end(), w, w + strlen(w));
+    line += strlen(w) + 1;
+    text.push_back(line > 72 ? '\n' : ' ');
+    if (line > 72)
+      line = 0;
+  }
+  text.resize(corpus_size);
+  return text;
+}
+
+// kernel time of one search in ns; host time if the events have no profiling info
+double time_search(queue &q, buffer<char,1> &text_buf, size_t text_size, uint32_t n_wgroups,
+  int wgroup_size, const std::vector<char4> &pattern, size_t chars_per_item,
+  Partition partition, uint32_t *result, bool &wall_clock)
+{
+  buffer<uint32_t,1> group_result_buf{range<1>(n_wgroups * NUM_KEYWORDS)};
+  std::fill(result, result + NUM_KEYWORDS, 0);
+  dpc_common::TimeInterval host_time;
+  double ns;
+  {
+    buffer<uint32_t,1> global_result_buf(result, range<1>(NUM_KEYWORDS));
+    SearchEvents e = submit_string_search(q, text_buf, text_size, n_wgroups, wgroup_size,
+      pattern, chars_per_item, group_result_buf, global_result_buf, partition);
+    q.wait();
+    ns = host_time.Elapsed() * 1e9;
+    try {
+      double kernel_ns = kernel_time_ns(e);
+      if (kernel_ns > 0)
+        ns = kernel_ns;
+      else
+        wall_clock = true;
+    } catch (exception const &) {
+      wall_clock = true;
+    }
+  }
+  return ns;
+}
+
+void write_report(std::ostream &out, const std::vector<BenchPoint> &points, bool csv,
+  const std::string &device_name, size_t repeats)
+{
+  if (csv) {
+    out << "corpus_bytes,wg_size,n_groups,chars_per_item,partition,repeats,"
+           "median_ms,p95_ms,gbps,timer,valid\n";
+    for (auto &p : points)
+      out << p.corpus_size << ',' << p.wgroup_size << ',' << p.n_wgroups << ','
+          << p.chars_per_item << ',' << partition_name(p.partition) << ',' << repeats << ','
+          << p.median_ns * 1e-6 << ',' << p.p95_ns * 1e-6 << ','
+          << p.corpus_size / p.median_ns << ',' << (p.wall_clock ? "wall" : "kernel") << ','
+          << (p.valid ? "true" : "false") << '\n';
+    return;
+  }
+  out << "{\n  \"device\": \"" << device_name << "\",\n  \"repeats\": " << repeats
+      << ",\n  \"results\": [\n";
+  for (size_t i = 0; i < points.size(); i++) {
+    const BenchPoint &p = points[i];
+    out << "    {\"corpus_bytes\": " << p.corpus_size << ", \"wg_size\": " << p.wgroup_size
+        << ", \"n_groups\": " << p.n_wgroups << ", \"chars_per_item\": " << p.chars_per_item
+        << ", \"partition\": \"" << partition_name(p.partition) << "\""
+        << ", \"median_ms\": " << p.median_ns * 1e-6 << ", \"p95_ms\": " << p.p95_ns * 1e-6
+        << ", \"gbps\": " << p.corpus_size / p.median_ns
+        << ", \"timer\": \"" << (p.wall_clock ? "wall" : "kernel") << "\""
+        << ", \"valid\": " << (p.valid ? "true" : "false") << "}"
+        << (i + 1 < points.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+  // Create device selector for the device of your interest.
+#if FPGA_EMULATOR
+  // DPC++ extension: FPGA emulator selector on systems without FPGA card.
+  ext::intel::fpga_emulator_selector d_selector;
+#elif FPGA || FPGA_PROFILE
+  // DPC++ extension: FPGA selector on systems with FPGA card.
+  ext::intel::fpga_selector d_selector;
+#else
+  // The default device selector will select the most performant device.
+  default_selector d_selector;
+#endif
+
+  std::vector<char4> pattern;
+  pattern.push_back({'t','h','a','t'});
+  pattern.push_back({'w','i','t','h'});
+  pattern.push_back({'h','a','v','e'});
+  pattern.push_back({'f','r','o','m'});
+
+  std::vector<size_t> sizes = {1 << 20, 16 << 20, 64 << 20};
+  std::vector<size_t> wg_sizes;
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+  wg_sizes.push_back(MAX_WG_SIZE);
+#else
+  for (size_t wg = 4; wg <= MAX_WG_SIZE; wg *= 2)
+    wg_sizes.push_back(wg);
+#endif
+  std::vector<size_t> group_counts;
+  std::vector<size_t> item_chars = {256, 4096};
+  size_t repeats = 10;
+  bool csv = false;
+  const char *report_file = NULL;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "-s") == 0 && a + 1 < argc)
+      sizes = parse_list(argv[++a]);
+    else if (strcmp(argv[a], "-w") == 0 && a + 1 < argc)
+      wg_sizes = parse_list(argv[++a]);
+    else if (strcmp(argv[a], "-g") == 0 && a + 1 < argc)
+      group_counts = parse_list(argv[++a]);
+    else if (strcmp(argv[a], "-c") == 0 && a + 1 < argc)
+      item_chars = parse_list(argv[++a]);
+    else if (strcmp(argv[a], "-r") == 0 && a + 1 < argc)
+      repeats = std::max<size_t>(1, strtoul(argv[++a], NULL, 10));
+    else if (strcmp(argv[a], "-f") == 0 && a + 1 < argc)
+      csv = strcmp(argv[++a], "csv") == 0;
+    else if (strcmp(argv[a], "-o") == 0 && a + 1 < argc)
+      report_file = argv[++a];
+    else {
+      std::cout << "Unknown option " << argv[a] << std::endl;
+      exit(1);
+    }
+  }
+
+  std::vector<BenchPoint> points;
+  std::string device_name;
+  try {
+    queue q(d_selector, dpc_common::exception_handler,
+            property::queue::enable_profiling{});
+    device dev = q.get_device();
+    device_name = dev.get_info<info::device::name>();
+    auto num_cmpunit = dev.get_info<info::device::max_compute_units>();
+    auto max_wg_size = dev.get_info<info::device::max_work_group_size>();
+    std::cerr << "Running on device: " << device_name << ", compute units = "
+              << num_cmpunit << std::endl;
+    if (group_counts.empty())
+      group_counts = {1, num_cmpunit, 4 * (size_t)num_cmpunit};
+    std::sort(group_counts.begin(), group_counts.end());
+    group_counts.erase(std::unique(group_counts.begin(), group_counts.end()), group_counts.end());
+
+    for (size_t corpus_size : sizes) {
+      if (corpus_size < KEYWORD_LEN)
+        continue;
+      std::vector<char> text = generate_corpus(corpus_size);
+      uint32_t expected[NUM_KEYWORDS] = {0};
+      count_keywords_host(pattern, text.data(), corpus_size, expected);
+      // the corpus stays on the device for all the configurations
+      buffer<char,1> text_buf(text.data(), range<1>(corpus_size));
+
+      for (size_t wg : wg_sizes) {
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+        bool wg_ok = wg == MAX_WG_SIZE;
+#else
+        bool wg_ok = wg >= 1 && wg <= MAX_WG_SIZE && wg <= max_wg_size;
+#endif
+        if (!wg_ok) {
+          std::cerr << "skipping work-group size " << wg << " (this build supports "
+                    << "up to " << MAX_WG_SIZE << ", rebuild with -DWG_SIZE=<n>)" << std::endl;
+          continue;
+        }
+        // (n_wgroups, chars_per_item) pairs: each -g value with the
+        // chars_per_item that covers the corpus, and each -c value with
+        // the number of work-groups that covers it
+        std::vector<std::pair<uint32_t, size_t>> shapes;
+        for (size_t g : group_counts)
+          if (g > 0)
+            shapes.push_back({(uint32_t)g, (corpus_size + g * wg - 1) / (g * wg)});
+        for (size_t cpi : item_chars)
+          if (cpi > 0)
+            shapes.push_back({(uint32_t)((corpus_size + cpi * wg - 1) / (cpi * wg)), cpi});
+        std::sort(shapes.begin(), shapes.end());
+        shapes.erase(std::unique(shapes.begin(), shapes.end()), shapes.end());
+
+        for (auto &shape : shapes)
+          for (Partition partition : {CONTIGUOUS, INTERLEAVED}) {
+            BenchPoint p = {corpus_size, (int)wg, shape.first, shape.second, partition,
+                            0, 0, false, true};
+            uint32_t result[NUM_KEYWORDS];
+            std::vector<double> samples;
+            for (size_t r = 0; r <= repeats; r++) {
+              double ns = time_search(q, text_buf, corpus_size, p.n_wgroups, p.wgroup_size,
+                pattern, p.chars_per_item, partition, result, p.wall_clock);
+              // the first run is a warm-up that also moves the text to the device
+              if (r > 0)
+                samples.push_back(ns);
+              p.valid &= std::equal(result, result + NUM_KEYWORDS, expected);
+            }
+            std::sort(samples.begin(), samples.end());
+            p.median_ns = samples[samples.size() / 2];
+            p.p95_ns = samples[(samples.size() * 95 + 99) / 100 - 1];
+            points.push_back(p);
+            std::cerr << corpus_size << " bytes, wg " << wg << ", groups " << p.n_wgroups
+                      << ", chars/item " << p.chars_per_item << ", "
+                      << partition_name(partition) << ": median " << p.median_ns * 1e-6
+                      << " ms, " << corpus_size / p.median_ns << " GB/s"
+                      << (p.valid ? "" : " (WRONG COUNTS)") << std::endl;
+          }
+      }
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught for word count.\n";
+    std::terminate();
+  }
+
+  if (report_file != NULL) {
+    std::ofstream out(report_file);
+    if (!out) {
+      perror("Couldn't create the report file");
+      exit(1);
+    }
+    write_report(out, points, csv, device_name, repeats);
+  } else {
+    write_report(std::cout, points, csv, device_name, repeats);
+  }
+
+  for (auto &p : points)
+    if (!p.valid)
+      return 1;
+  return 0;
+}
@@ -28,150 +28,25 @@
 //https://software.intel.com/content/www/us/en/develop/documentation/oneapi-fpga-optimization-guide/top/optimize-your-design/resource-use/specify-a-work-group-size.html
 
 
-#include <CL/sycl.hpp>
-#include <array>
-#include <iostream>
-#include "dpc_common.hpp"
-#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
-#include <sycl/ext/intel/fpga_extensions.hpp>
-#endif
-
-using namespace sycl;
-
-#define TEXT_FILE "kafka.txt"
-// number of keywords to search
-#define NUM_KEYWORDS 4
-
-constexpr unsigned MAX_WG_SIZE = 16;
-//constexpr unsigned CHAR_PER_WORKITEM = 1024;
-
-// templates for atomic ref operations
-template <typename T>
-using local_atomic_ref = ext::oneapi::atomic_ref<
-  T,
-  ext::oneapi::memory_order::relaxed,
-  ext::oneapi::memory_scope::work_group,
-  access::address_space::local_space>;
-
-template <typename T>
-using global_atomic_ref = ext::oneapi::atomic_ref<
-  T,
-  ext::oneapi::memory_order::relaxed,
-  ext::oneapi::memory_scope::system,
-  access::address_space::global_space>;
+#include <cstring>
+#include "word-count.hpp"
+#include "string-search.hpp"
+#include "coop-search.hpp"
+#include "aho-corasick.hpp"
+#include "rabin-karp.hpp"
+#include "shift-or.hpp"
+#include "approx-search.hpp"
+#include "mapped-file.hpp"
+#include "match-positions.hpp"
+#include "word-histogram.hpp"
+#include "ngram-count.hpp"
+#include "suffix-array.hpp"
+#include "corpus.hpp"
+#include "follow.hpp"
+#include "query-server.hpp"
 
 size_t text_size;
 
-//************************************
-// Word Count in DPC++ on device: 
-//************************************
-void string_search(queue &q, uint32_t total_num_workitems, uint32_t n_wgroups, 
-  int wgroup_size, std::vector<char4> pattern, char* text, size_t chars_per_item, uint32_t* global_result) 
-{
-#if FPGA || FPGA_PROFILE
-  double total_kernel_time_ns = 0;
-#endif
-
-  // buffers for device
-  buffer<char,1> text_buf(text, range<1>(text_size));
-  buffer<uint32_t, 1> global_result_buf(global_result, range<1>(NUM_KEYWORDS));
-
-  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
-  std::cout << "wgroup_size = " << wgroup_size << std::endl;
-
-  char4 keywords[NUM_KEYWORDS];
-  for(int k = 0; k < NUM_KEYWORDS ; k++){
-    keywords[k] = pattern[k];
-  }
-
-  event e = q.submit([&] (handler& h) {
-    // allocate local memory
-    // to allow each workgroup has a local memory space of int32_t*NUM_KEYWORDS
-    // for maintaining a set of keyword counters for all the workitems in a workgroup
-    accessor <uint32_t, 1,
-      access::mode::read_write,
-      access::target::local>
-    local_mem(range<1>(NUM_KEYWORDS), h);
-
-    // point to global memory where the final results are stored
-    auto global_mem = global_result_buf.get_access<access::mode::read_write>(h);
-
-    // point to global memory where the text are stored
-    auto text_mem = text_buf.get_access<access::mode::read>(h);
-    auto text_max_len = text_size;
-    // use nd_range to specify kernels' global size and local size.
-    // in this case, we use one-dimensional nd_range
-    // the first range object specifies the number of (total) work items per dimension
-    // the second range object specifies the number of work items in a work group
-    h.parallel_for<class reduction_kernel>(
-      nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
-      [=] (nd_item<1> item) 
-      [[intel::max_work_group_size(1, 1, MAX_WG_SIZE), 
-        sycl::reqd_work_group_size(1,1,MAX_WG_SIZE),
-        intel::num_simd_work_items(MAX_WG_SIZE)]] 
-      {
-
-        // initialize local data
-        size_t local_id = item.get_local_id(0);
-
-        if (local_id == 0) {
-          local_mem[0] = 0;
-          local_mem[1] = 0;
-          local_mem[2] = 0;
-          local_mem[3] = 0;
-        }
-        item.barrier(sycl::access::fence_space::local_space);         
-
-        // Each work item will process char_per_item characters
-        int item_offset = local_id * chars_per_item;
-
-        /* Iterate through characters in text */
-        for(int i=item_offset; i<item_offset + chars_per_item; i++) {
-          // check bounds of text buffer
-          if(i > text_max_len-4)
-            break;
-          //load one four-character word
-          char4 text_word;
-          text_word.load(0, text_mem.get_pointer()+i);
-          for(int k = 0; k < NUM_KEYWORDS ; k++){
-            if (text_word.x() == keywords[k].x() &&
-                text_word.y() == keywords[k].y() &&
-                text_word.z() == keywords[k].z() &&
-                text_word.w() == keywords[k].w()
-              )
-            {
-              // increment the count (in local mem) ATOMICALLY for keywords[k]
-              local_atomic_ref<uint32_t>(local_mem[k])++;
-            }
-          }
-        }
-
-        item.barrier(sycl::access::fence_space::local_space); 
-
-        if( local_id == 0) {
-          global_atomic_ref<uint32_t>(global_mem[0]) += local_mem[0];
-          global_atomic_ref<uint32_t>(global_mem[1]) += local_mem[1];
-          global_atomic_ref<uint32_t>(global_mem[2]) += local_mem[2];
-          global_atomic_ref<uint32_t>(global_mem[3]) += local_mem[3];
-        }
-
-    }); // parallel_for
-  }); // q.submit
-#if FPGA || FPGA_PROFILE
-    // Query event e for kernel profiling information
-    // (blocks until command groups associated with e complete)
-    double kernel_time_ns =
-      e.get_profiling_info<info::event_profiling::command_end>() -
-      e.get_profiling_info<info::event_profiling::command_start>();
-
-    total_kernel_time_ns += kernel_time_ns;
-
-    // Report profiling info as it takes multiple steps
-    std::cout << " Total Kernel compute time:  " << total_kernel_time_ns * 1e-6 << " ms\n";
-#endif
-}
-
-
 int main(int argc, char **argv) {
   // Create device selector for the device of your interest.
 #if FPGA_EMULATOR
@@ -195,31 +70,310 @@ int main(int argc, char **argv) {
   pattern.push_back({'f','r','o','m'});
 
   FILE *text_handle;
-  char *text;
+  const char *text;
+  MappedFile mapped;
   size_t chars_per_item;
   size_t n_local_results;
 
-  /* Read text file and place content into buffer */
-  if (argc != 2)
-    text_handle = fopen(TEXT_FILE, "r");
-  else
-    text_handle = fopen(argv[1], "r");
-  if(text_handle == NULL) {
-      perror("Couldn't find the text file");
+  // usage: word-count [-k keyword_file | -p pattern_file | -f top_k | -q | -u socket_path |
+  //                    -b | -a query_file | -d corpus] [-n n] [-e distance] [-s chunk_size | -c chunk_size]
+  //                   [-r] [-t [-w window]] [-j] [-m] [-i] [-o match_file] [text_file]
+  //   -k : count every keyword listed (one per line) in keyword_file with the
+  //        Aho-Corasick engine instead of the four built-in keywords
+  //   -r : search the keywords of -k (1 to 64 bytes long) with the
+  //        Rabin-Karp engine instead
+  //   -e : count the occurrences within edit distance `distance` of the
+  //        built-in keywords, or of the keywords of -k, with Myers' algorithm
+  //   -p : count every pattern listed (one per line) in pattern_file with the
+  //        Shift-Or engine; '?' matches any byte, [a-z] or [^ ] a byte class
+  //   -f : count every distinct word of the text and report the top_k most
+  //        frequent ones
+  //   -n : count the n-grams (runs of n consecutive words) instead, reporting
+  //        the top_k (default 10) most frequent ones; with -o the whole
+  //        n-gram table is written to match_file, one "count<TAB>n-gram"
+  //        line each
+  //   -s : stream the text through the device in chunks of chunk_size bytes
+  //        (K/M/G suffixes allowed) instead of loading the whole file
+  //   -c : count the built-in keywords on the device and on the host SIMD
+  //        matcher threads at once, handing out chunks of chunk_size bytes
+  //        (K/M/G suffixes allowed) to whichever engine is free
+  //   -t : follow the text file as it grows, counting the built-in keywords
+  //        in the appended bytes only; the offset reached is saved to
+  //        text_file.follow, so a new follower resumes from there
+  //   -w : with -t, also report the counts of the last `window` bytes (K/M/G
+  //        suffixes allowed) or seconds (30s, 10min, 2h)
+  //   -j : bake the built-in keywords into the search kernel as
+  //        specialization constants (CPU and GPU only)
+  //   -m : memory map the text file and let the device read it in place
+  //   -i : interleave the work-items over 64-byte segments of the text
+  //        instead of giving each one a contiguous slice
+  //   -o : write the offset of every built-in keyword occurrence to
+  //        match_file, one "keyword_id offset" pair per line
+  //   -b : build the suffix array of the text and save it to text_file.sa
+  //   -a : count every substring listed (one per line) in query_file with
+  //        binary searches in the suffix array saved by -b
+  //   -d : count the built-in keywords in every document of corpus, a
+  //        directory or a file listing one document path per line, and
+  //        report their document frequencies; with -o the TF-IDF table is
+  //        written to match_file
+  //   -q : keep the text on the device and answer keyword queries, one per
+  //        line, read from stdin
+  //   -u : like -q, but serve the queries on a Unix socket at socket_path
+  const char *text_file = TEXT_FILE;
+  const char *keyword_file = NULL;
+  const char *pattern_file = NULL;
+  bool rabin_karp = false;
+  int edit_distance = -1;
+  int ngram_n = 0;
+  size_t top_k = 0;
+  size_t chunk_size = 0;
+  size_t coop_chunk_size = 0;
+  bool use_mmap = false;
+  bool baked = false;
+  Partition partition = CONTIGUOUS;
+  bool serve = false;
+  const char *match_file = NULL;
+  const char *socket_path = NULL;
+  bool build_index = false;
+  const char *query_file = NULL;
+  const char *corpus_path = NULL;
+  bool follow = false;
+  WindowRing window;
+  for (int a = 1; a < argc; a++) {
+    if (strcmp(argv[a], "-k") == 0 && a + 1 < argc)
+      keyword_file = argv[++a];
+    else if (strcmp(argv[a], "-r") == 0)
+      rabin_karp = true;
+    else if (strcmp(argv[a], "-e") == 0 && a + 1 < argc)
+      edit_distance = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-p") == 0 && a + 1 < argc)
+      pattern_file = argv[++a];
+    else if (strcmp(argv[a], "-f") == 0 && a + 1 < argc)
+      top_k = strtoul(argv[++a], NULL, 10);
+    else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc)
+      ngram_n = atoi(argv[++a]);
+    else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc)
+      chunk_size = parse_size(argv[++a]);
+    else if (strcmp(argv[a], "-c") == 0 && a + 1 < argc)
+      coop_chunk_size = parse_size(argv[++a]);
+    else if (strcmp(argv[a], "-m") == 0)
+      use_mmap = true;
+    else if (strcmp(argv[a], "-j") == 0)
+      baked = true;
+    else if (strcmp(argv[a], "-i") == 0)
+      partition = INTERLEAVED;
+    else if (strcmp(argv[a], "-o") == 0 && a + 1 < argc)
+      match_file = argv[++a];
+    else if (strcmp(argv[a], "-q") == 0)
+      serve = true;
+    else if (strcmp(argv[a], "-d") == 0 && a + 1 < argc)
+      corpus_path = argv[++a];
+    else if (strcmp(argv[a], "-t") == 0)
+      follow = true;
+    else if (strcmp(argv[a], "-w") == 0 && a + 1 < argc)
+      window = parse_window(argv[++a]);
+    else if (strcmp(argv[a], "-b") == 0)
+      build_index = true;
+    else if (strcmp(argv[a], "-a") == 0 && a + 1 < argc)
+      query_file = argv[++a];
+    else if (strcmp(argv[a], "-u") == 0 && a + 1 < argc) {
+      serve = true;
+      socket_path = argv[++a];
+    }
+    else
+      text_file = argv[a];
+  }
+  if (rabin_karp && (keyword_file == NULL || edit_distance >= 0)) {
+    std::cout << "Rabin-Karp search (-r) needs a keyword file (-k) and no edit distance (-e)" << std::endl;
+    exit(1);
+  }
+  if (window.unit != WINDOW_NONE && !follow) {
+    std::cout << "Window counts (-w) need follow mode (-t)" << std::endl;
+    exit(1);
+  }
+  if (follow &&
+      (keyword_file != NULL || pattern_file != NULL || top_k != 0 || ngram_n != 0 ||
+       edit_distance >= 0 || chunk_size != 0 || serve || use_mmap || match_file != NULL ||
+       build_index || query_file != NULL || corpus_path != NULL || coop_chunk_size != 0)) {
+    std::cout << "Follow mode (-t) can only be combined with -w and -i" << std::endl;
+    exit(1);
+  }
+  if (corpus_path != NULL &&
+      (keyword_file != NULL || pattern_file != NULL || top_k != 0 || ngram_n != 0 ||
+       edit_distance >= 0 || chunk_size != 0 || serve || use_mmap || build_index ||
+       query_file != NULL || coop_chunk_size != 0)) {
+    std::cout << "Corpus mode (-d) can only be combined with -o" << std::endl;
+    exit(1);
+  }
+  if (coop_chunk_size != 0 &&
+      (keyword_file != NULL || pattern_file != NULL || top_k != 0 || ngram_n != 0 ||
+       edit_distance >= 0 || chunk_size != 0 || serve || match_file != NULL ||
+       build_index || query_file != NULL)) {
+    std::cout << "Cooperative search (-c) can only be combined with -m and -i" << std::endl;
+    exit(1);
+  }
+  if ((build_index || query_file != NULL) &&
+      (build_index + (query_file != NULL) + (keyword_file != NULL) + (pattern_file != NULL) +
+       (top_k != 0) + (ngram_n != 0) + (edit_distance >= 0) + (chunk_size != 0) + serve +
+       (match_file != NULL) > 1)) {
+    std::cout << "Index build (-b) and index queries (-a) can only be combined with -m and -i" << std::endl;
+    exit(1);
+  }
+  if (ngram_n != 0) {
+    if (ngram_n < 1 || ngram_n > NGRAM_MAX_N) {
+      std::cout << "N-gram length (-n) must be between 1 and " << NGRAM_MAX_N << std::endl;
+      exit(1);
+    }
+    if (keyword_file != NULL || pattern_file != NULL || edit_distance >= 0 ||
+        chunk_size != 0 || serve) {
+      std::cout << "N-gram counting (-n) can only be combined with -f, -o, -m and -i" << std::endl;
+      exit(1);
+    }
+    if (top_k == 0)
+      top_k = 10;
+  }
+  if ((keyword_file != NULL) + (pattern_file != NULL) + (top_k != 0) > 1) {
+    std::cout << "Keyword search (-k), pattern search (-p) and word frequency (-f) are exclusive" << std::endl;
+    exit(1);
+  }
+  if (chunk_size != 0 && (keyword_file != NULL || pattern_file != NULL || top_k != 0)) {
+    std::cout << "Streaming (-s) is only supported for the built-in keywords" << std::endl;
+    exit(1);
+  }
+  if (serve && (keyword_file != NULL || pattern_file != NULL || top_k != 0 || chunk_size != 0)) {
+    std::cout << "Query serving (-q, -u) cannot be combined with -k, -p, -f or -s" << std::endl;
+    exit(1);
+  }
+  if (match_file != NULL && ngram_n == 0 && corpus_path == NULL && (keyword_file != NULL || pattern_file != NULL ||
+                                             top_k != 0 || chunk_size != 0 || serve)) {
+    std::cout << "Match positions (-o) are only supported for the built-in keywords" << std::endl;
+    exit(1);
+  }
+  if (edit_distance >= 0 && (pattern_file != NULL || top_k != 0 || chunk_size != 0 ||
+                             serve || match_file != NULL)) {
+    std::cout << "Approximate search (-e) can only be combined with -k, -m and -i" << std::endl;
+    exit(1);
+  }
+  if (baked &&
+      (keyword_file != NULL || pattern_file != NULL || top_k != 0 || ngram_n != 0 ||
+       edit_distance >= 0 || serve || match_file != NULL || build_index ||
+       query_file != NULL || corpus_path != NULL || follow || coop_chunk_size != 0)) {
+    std::cout << "Baked keywords (-j) can only be combined with -s, -m and -i" << std::endl;
+    exit(1);
+  }
+#if !HAVE_BAKED_SEARCH
+  if (baked) {
+    std::cout << "Baked keywords (-j) need a JIT-compiled CPU or GPU build" << std::endl;
+    exit(1);
+  }
+#endif
+  if (chunk_size != 0 && use_mmap) {
+    std::cout << "Streaming (-s) and memory mapping (-m) are exclusive" << std::endl;
+    exit(1);
+  }
+
+  ACAutomaton ac;
+  RKDictionary rk;
+  std::vector<uint32_t> ac_result;
+  ApproxKeywords ak;
+  std::vector<uint32_t> ak_result;
+  ShiftOrProgram so;
+  std::vector<uint32_t> so_result;
+  VocabProfile profile;
+  NgramTable ngrams;
+  std::vector<uint32_t> sa;
+  SuffixIndex sa_index;
+  std::vector<std::string> sa_queries;
+  std::vector<uint32_t> sa_result;
+  std::vector<KeywordMatch> matches;
+  Corpus corpus;
+  CorpusStats corpus_stats;
+  if (edit_distance >= 0) {
+    std::vector<std::string> keywords;
+    if (keyword_file != NULL)
+      keywords = read_keyword_file(keyword_file);
+    else
+      for (auto &p : pattern)
+        keywords.push_back(std::string{p[0], p[1], p[2], p[3]});
+    if (keywords.empty()) {
+      std::cout << "No keywords found in " << keyword_file << std::endl;
+      exit(1);
+    }
+    ak = build_approx_keywords(keywords, edit_distance);
+    std::cout << "keywords = " << keywords.size() << ", edit distance = "
+              << edit_distance << std::endl;
+  } else if (keyword_file != NULL) {
+    ac = build_ac_automaton(read_keyword_file(keyword_file));
+    if (ac.keywords.empty()) {
+      std::cout << "No keywords found in " << keyword_file << std::endl;
+      exit(1);
+    }
+    std::cout << "keywords = " << ac.keywords.size() << ", automaton states = "
+              << ac.num_states << ", byte classes = " << ac.num_classes << std::endl;
+    // the automaton still checks the Rabin-Karp results on host
+    if (rabin_karp) {
+      rk = build_rk_dictionary(ac.keywords);
+      std::cout << "keyword lengths = " << rk.group_len.size() << ", hash set slots = "
+                << rk.slot_hash.size() << std::endl;
+    }
+  }
+  if (query_file != NULL) {
+    sa_queries = read_keyword_file(query_file);
+    if (sa_queries.empty()) {
+      std::cout << "No queries found in " << query_file << std::endl;
+      exit(1);
+    }
+    std::cout << "queries = " << sa_queries.size() << std::endl;
+  }
+  if (pattern_file != NULL) {
+    so = build_shift_or(read_keyword_file(pattern_file));
+    if (so.patterns.empty()) {
+      std::cout << "No patterns found in " << pattern_file << std::endl;
       exit(1);
+    }
+    std::cout << "patterns = " << so.patterns.size() << ", state words = "
+              << so.num_words << std::endl;
   }
-  fseek(text_handle, 0, SEEK_END);
-  text_size = ftell(text_handle)-1;
-  rewind(text_handle);
-  text = (char*)calloc(text_size, sizeof(char));
-  fread(text, sizeof(char), text_size, text_handle);
-  fclose(text_handle);
-  std::cout << "file size = " << text_size << " bytes " << std::endl;
 
-  char4 keywords[NUM_KEYWORDS];
-  for(int k = 0; k < NUM_KEYWORDS ; k++){
-    keywords[k] = pattern[k];
+  if (follow) {
+    // the follower reads the appended bytes itself
+    text = NULL;
+    text_size = 0;
+  } else if (corpus_path != NULL) {
+    dpc_common::TimeInterval load_time;
+    load_corpus(corpus_path, corpus);
+    double load_time_s = load_time.Elapsed();
+    text = corpus.text.data();
+    text_size = corpus.text.size();
+    std::cout << "documents = " << corpus.paths.size() << ", loaded in " << load_time_s * 1000
+              << " ms" << std::endl;
+  } else if (use_mmap) {
+    // map the file instead of copying it into a host array
+    mapped = map_text_file(text_file);
+    text = mapped.data;
+    text_size = mapped.size-1;
+  } else {
+    /* Read text file and place content into buffer */
+    text_handle = fopen(text_file, "r");
+    if(text_handle == NULL) {
+        perror("Couldn't find the text file");
+        exit(1);
+    }
+    fseek(text_handle, 0, SEEK_END);
+    text_size = ftell(text_handle)-1;
+    rewind(text_handle);
+    // in streaming mode the file stays open and is read chunk by chunk
+    if (chunk_size == 0) {
+      char *file_text = (char*)calloc(text_size, sizeof(char));
+      fread(file_text, sizeof(char), text_size, text_handle);
+      fclose(text_handle);
+      text = file_text;
+    }
   }
+  if (!follow)
+    std::cout << "file size = " << text_size << " bytes " << std::endl;
+  if (query_file != NULL)
+    sa_index = load_suffix_index(suffix_index_path(text_file), text_size);
 
 #ifndef FPGA_PROFILE
   // Query about the platform
@@ -242,6 +396,9 @@ int main(int argc, char **argv) {
   try {
     queue q(d_selector, dpc_common::exception_handler,
             property::queue::enable_profiling{});
+    // specialized search kernels built for -j, released before the runtime
+    // shuts down
+    BakedSearchCache baked_cache;
 
     device dev = q.get_device();
 
@@ -252,9 +409,6 @@ int main(int argc, char **argv) {
         dev.get_info<cl::sycl::info::device::max_compute_units>();
     std::cout << "num of compute units (reported)= " << num_cmpunit << std::endl;
 
-    num_cmpunit = 1 < num_cmpunit ? 1 : num_cmpunit;
-    std::cout << "num of compute units (set as)= " << num_cmpunit << std::endl;
-
     auto wgroup_size = dev.get_info<info::device::max_work_group_size>();
     std::cout << "max work group size = " << wgroup_size << std::endl;
     if (wgroup_size > MAX_WG_SIZE) {
@@ -273,23 +427,16 @@ int main(int argc, char **argv) {
     auto max_mem_alloc_size = dev.get_info<info::device::max_mem_alloc_size>();
     std::cout << "max_mem_alloc_size = " << max_mem_alloc_size << std::endl;
 
-    auto has_local_mem = dev.is_host()
-          || (dev.get_info<info::device::local_mem_type>()
-          != info::local_mem_type::none);
+    // the keyword search keeps its counts in private memory; the modes that
+    // use local memory check that there is enough of it themselves
     auto local_mem_size = dev.get_info<info::device::local_mem_size>();
-    if (!has_local_mem
-        || local_mem_size < (wgroup_size * sizeof(int32_t)*NUM_KEYWORDS))
-    {
-        throw "Device doesn't have enough local memory!";
-    }
-    else
-    {
-      std::cout << "local_mem_size = " << local_mem_size << std::endl;
-    }
+    std::cout << "local_mem_size = " << local_mem_size << std::endl;
     
     auto global_mem_size = dev.get_info<info::device::global_mem_size>();
     std::cout << "global_mem_size = " << global_mem_size << std::endl;
 
+    // one work-group per compute unit, so that every core (or EU) of the
+    // device scans its own part of the text
     auto num_groups = num_cmpunit;
     auto total_num_workitems = num_groups * wgroup_size;
     chars_per_item = (size_t)(text_size + total_num_workitems - 1)/total_num_workitems;
@@ -298,14 +445,312 @@ int main(int argc, char **argv) {
     std::cout << "num_groups = " << num_groups << std::endl;
 
     // Word count in DPC++
-    string_search(q, total_num_workitems, num_groups, wgroup_size, pattern, text, 
-      chars_per_item, result);
+    if (follow)
+      follow_search(q, num_groups, wgroup_size, pattern, text_file, window, partition);
+    else if (corpus_path != NULL)
+      corpus_search(q, num_groups, wgroup_size, pattern, corpus, chars_per_item, corpus_stats);
+    else if (build_index)
+      build_suffix_array(q, num_groups, wgroup_size, text, text_size, sa);
+    else if (query_file != NULL)
+      suffix_index_search(q, num_groups, wgroup_size, sa_index, text, sa_queries, sa_result);
+    else if (serve)
+      serve_queries(q, num_groups, wgroup_size, text, text_size, chars_per_item, socket_path);
+    else if (ngram_n != 0)
+      ngram_count(q, num_groups, wgroup_size, text, text_size, chars_per_item, ngram_n,
+        match_file != NULL ? 0 : top_k, ngrams);
+    else if (top_k != 0)
+      word_histogram(q, num_groups, wgroup_size, text, text_size, chars_per_item, top_k, profile);
+    else if (edit_distance >= 0)
+      approx_search(q, num_groups, wgroup_size, ak, text, text_size, chars_per_item, ak_result);
+    else if (pattern_file != NULL)
+      shift_or_search(q, num_groups, wgroup_size, so, text, text_size, chars_per_item, so_result);
+    else if (keyword_file != NULL && rabin_karp)
+      rk_search(q, num_groups, wgroup_size, rk, text, text_size, chars_per_item, ac_result);
+    else if (keyword_file != NULL)
+      ac_search(q, num_groups, wgroup_size, ac, text, text_size, chars_per_item, ac_result);
+    else if (match_file != NULL)
+      match_positions(q, num_groups, wgroup_size, pattern, text, text_size, chars_per_item, matches);
+    else if (coop_chunk_size != 0)
+      coop_search(q, num_groups, wgroup_size, pattern, text, text_size, coop_chunk_size,
+        result, partition);
+    else if (chunk_size != 0)
+      stream_search(q, num_groups, wgroup_size, pattern, text_handle, text_size,
+        chunk_size, result, partition, baked ? &baked_cache : NULL);
+    else
+      string_search(q, total_num_workitems, num_groups, wgroup_size, pattern, text, 
+        text_size, chars_per_item, result, use_mmap, partition,
+        baked ? &baked_cache : NULL);
   
   } catch (exception const &e) {
     std::cout << "An exception is caught for word count.\n";
     std::terminate();
   }
 
+  if (serve) {
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return 0;
+  }
+
+  if (corpus_path != NULL) {
+    std::cout << "\n results computed on device:\n";
+    for (int k = 0; k < NUM_KEYWORDS; k++) {
+      uint64_t total = 0;
+      uint32_t best_doc = 0;
+      for (uint32_t d = 0; d < corpus_stats.num_docs; d++) {
+        total += corpus_stats.tf[(size_t)d * NUM_KEYWORDS + k];
+        if (corpus_stats.tf[(size_t)d * NUM_KEYWORDS + k] >
+            corpus_stats.tf[(size_t)best_doc * NUM_KEYWORDS + k])
+          best_doc = d;
+      }
+      std::cout << "keyword " << pattern[k][0] << pattern[k][1] << pattern[k][2] << pattern[k][3]
+                << " appears " << total << " times in " << corpus_stats.df[k] << " of "
+                << corpus_stats.num_docs << " documents, idf = "
+                << inverse_document_frequency(corpus_stats, k);
+      if (corpus_stats.df[k] != 0)
+        std::cout << ", highest tf-idf in " << corpus.paths[best_doc];
+      std::cout << std::endl;
+    }
+    if (match_file != NULL) {
+      write_tfidf(match_file, pattern, corpus, corpus_stats);
+      std::cout << "TF-IDF table written to " << match_file << std::endl;
+    }
+
+    CorpusStats host_stats;
+    dpc_common::TimeInterval corpus_exec_time;
+    corpus_search_host(pattern, corpus, host_stats);
+    double corpus_host_time_s = corpus_exec_time.Elapsed();
+    std::cout << "host compute time " << corpus_host_time_s * 1000 << " ms\n";
+
+    bool match = corpus_stats.tf == host_stats.tf &&
+                 std::equal(corpus_stats.df, corpus_stats.df + NUM_KEYWORDS, host_stats.df);
+    std::cout << "\n document statistics " << (match ? "match" : "DO NOT match")
+              << " the host results\n";
+    return match ? 0 : 1;
+  }
+
+  if (build_index) {
+    std::string index_path = suffix_index_path(text_file);
+    save_suffix_index(index_path, sa);
+    std::cout << "\n suffix array of " << sa.size() << " suffixes written to " << index_path << std::endl;
+
+    dpc_common::TimeInterval check_exec_time;
+    bool match = check_suffix_array(text, text_size, sa);
+    double check_host_time_s = check_exec_time.Elapsed();
+    std::cout << "host check time " << check_host_time_s * 1000 << " ms\n";
+    std::cout << "\n suffix array is " << (match ? "sorted" : "NOT sorted") << std::endl;
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return match ? 0 : 1;
+  }
+
+  if (query_file != NULL) {
+    std::cout << "\n results computed on device:\n";
+    for (size_t w = 0; w < sa_queries.size(); w++)
+      std::cout << "substring " << sa_queries[w] << " appears " << sa_result[w] << " times" << std::endl;
+
+    std::vector<uint32_t> sa_host_result;
+    dpc_common::TimeInterval sa_exec_time;
+    substring_count_host(text, text_size, sa_queries, sa_host_result);
+    double sa_host_time_s = sa_exec_time.Elapsed();
+    std::cout << "host compute time " << sa_host_time_s * 1000 << " ms\n";
+
+    size_t mismatches = 0;
+    for (size_t w = 0; w < sa_queries.size(); w++)
+      if (sa_result[w] != sa_host_result[w]) {
+        std::cout << "substring " << sa_queries[w] << " mismatch: device " << sa_result[w]
+                  << ", host " << sa_host_result[w] << std::endl;
+        mismatches++;
+      }
+    std::cout << "\n " << sa_queries.size() - mismatches << " of " << sa_queries.size()
+              << " substring counts match the host results\n";
+    unmap_text_file(sa_index.file);
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return mismatches == 0 ? 0 : 1;
+  }
+
+  if (ngram_n != 0) {
+    if (match_file != NULL) {
+      FILE *table_handle = fopen(match_file, "w");
+      if (table_handle == NULL) {
+        perror("Couldn't create the n-gram table file");
+        exit(1);
+      }
+      for (auto &g : ngrams.ngrams)
+        fprintf(table_handle, "%u\t%s\n", g.count, g.word.c_str());
+      fclose(table_handle);
+    }
+
+    std::cout << "\n results computed on device:\n";
+    std::cout << ngram_n << "-grams = " << ngrams.total_ngrams << ", distinct = "
+              << ngrams.distinct_ngrams << std::endl;
+    for (size_t k = 0; k < std::min(top_k, ngrams.ngrams.size()); k++)
+      std::cout << k + 1 << ". \"" << ngrams.ngrams[k].word << "\" appears "
+                << ngrams.ngrams[k].count << " times" << std::endl;
+    if (match_file != NULL)
+      std::cout << ngrams.ngrams.size() << " n-grams written to " << match_file << std::endl;
+
+    NgramTable host_ngrams;
+    dpc_common::TimeInterval ngram_exec_time;
+    ngram_count_host(text, text_size, ngram_n, match_file != NULL ? 0 : top_k, host_ngrams);
+    double ngram_host_time_s = ngram_exec_time.Elapsed();
+    std::cout << "host compute time " << ngram_host_time_s * 1000 << " ms\n";
+
+    // n-grams tied with the last count may legitimately differ, their counts may not
+    bool match = ngrams.total_ngrams == host_ngrams.total_ngrams &&
+                 ngrams.distinct_ngrams == host_ngrams.distinct_ngrams &&
+                 ngrams.ngrams.size() == host_ngrams.ngrams.size();
+    for (size_t k = 0; match && k < ngrams.ngrams.size(); k++)
+      match = ngrams.ngrams[k].count == host_ngrams.ngrams[k].count &&
+              (ngrams.ngrams[k].count == ngrams.ngrams.back().count ||
+               ngrams.ngrams[k].word == host_ngrams.ngrams[k].word);
+    std::cout << "\n n-gram frequencies " << (match ? "match" : "DO NOT match")
+              << " the host results (" << ngram_n << "-grams = " << host_ngrams.total_ngrams
+              << ", distinct = " << host_ngrams.distinct_ngrams << ")\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return match ? 0 : 1;
+  }
+
+  if (top_k != 0) {
+    std::cout << "\n results computed on device:\n";
+    std::cout << "tokens = " << profile.total_tokens << ", distinct = "
+              << profile.distinct_tokens << std::endl;
+    for (size_t k = 0; k < profile.top.size(); k++)
+      std::cout << k + 1 << ". " << profile.top[k].word << " appears "
+                << profile.top[k].count << " times" << std::endl;
+
+    VocabProfile host_profile;
+    dpc_common::TimeInterval vocab_exec_time;
+    word_histogram_host(text, text_size, top_k, host_profile);
+    double vocab_host_time_s = vocab_exec_time.Elapsed();
+    std::cout << "host compute time " << vocab_host_time_s * 1000 << " ms\n";
+
+    // words tied with the k-th count may legitimately differ, their counts may not
+    bool match = profile.total_tokens == host_profile.total_tokens &&
+                 profile.distinct_tokens == host_profile.distinct_tokens &&
+                 profile.top.size() == host_profile.top.size();
+    for (size_t k = 0; match && k < profile.top.size(); k++)
+      match = profile.top[k].count == host_profile.top[k].count &&
+              (profile.top[k].count == profile.top.back().count ||
+               profile.top[k].word == host_profile.top[k].word);
+    std::cout << "\n word frequencies " << (match ? "match" : "DO NOT match")
+              << " the host results (tokens = " << host_profile.total_tokens
+              << ", distinct = " << host_profile.distinct_tokens << ")\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return match ? 0 : 1;
+  }
+
+  if (match_file != NULL) {
+    FILE *match_handle = fopen(match_file, "w");
+    if (match_handle == NULL) {
+      perror("Couldn't create the match file");
+      exit(1);
+    }
+    for (auto &m : matches)
+      fprintf(match_handle, "%u %llu\n", m.keyword, (unsigned long long)m.offset);
+    fclose(match_handle);
+
+    std::cout << "\n results computed on device:\n";
+    for (int k = 0; k < NUM_KEYWORDS; k++)
+      std::cout << "keyword " << k << " (" << pattern[k][0] << pattern[k][1] << pattern[k][2]
+                << pattern[k][3] << ") appears " << std::count_if(matches.begin(), matches.end(),
+                   [k](const KeywordMatch &m) { return m.keyword == (uint32_t)k; })
+                << " times" << std::endl;
+    std::cout << matches.size() << " positions written to " << match_file << std::endl;
+
+    std::vector<KeywordMatch> host_matches;
+    dpc_common::TimeInterval match_exec_time;
+    match_positions_host(pattern, text, text_size, host_matches);
+    double match_host_time_s = match_exec_time.Elapsed();
+    std::cout << "host compute time " << match_host_time_s * 1000 << " ms\n";
+
+    bool match = matches == host_matches;
+    std::cout << "\n match positions " << (match ? "match" : "DO NOT match")
+              << " the host results (" << host_matches.size() << " positions)\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return match ? 0 : 1;
+  }
+
+  if (edit_distance >= 0) {
+    std::cout << "\n results computed on device:\n";
+    for (size_t w = 0; w < ak.keywords.size(); w++)
+      std::cout << "keyword " << ak.keywords[w] << " appears " << ak_result[w]
+                << " times within edit distance " << edit_distance << std::endl;
+
+    std::vector<uint32_t> ak_host_result;
+    dpc_common::TimeInterval ak_exec_time;
+    approx_search_host(ak, text, text_size, ak_host_result);
+    double ak_host_time_s = ak_exec_time.Elapsed();
+    std::cout << "host compute time " << ak_host_time_s * 1000 << " ms\n";
+
+    size_t mismatches = 0;
+    for (size_t w = 0; w < ak.keywords.size(); w++)
+      if (ak_result[w] != ak_host_result[w]) {
+        std::cout << "keyword " << ak.keywords[w] << " mismatch: device " << ak_result[w]
+                  << ", host " << ak_host_result[w] << std::endl;
+        mismatches++;
+      }
+    std::cout << "\n " << ak.keywords.size() - mismatches << " of " << ak.keywords.size()
+              << " keyword counts match the host results\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return mismatches == 0 ? 0 : 1;
+  }
+
+  if (pattern_file != NULL) {
+    std::cout << "\n results computed on device:\n";
+    for (size_t p = 0; p < so.patterns.size(); p++)
+      std::cout << "pattern " << so.patterns[p] << " appears " << so_result[p] << " times" << std::endl;
+
+    std::vector<uint32_t> so_host_result;
+    dpc_common::TimeInterval so_exec_time;
+    shift_or_search_host(so, text, text_size, so_host_result);
+    double so_host_time_s = so_exec_time.Elapsed();
+    std::cout << "host compute time " << so_host_time_s * 1000 << " ms\n";
+
+    size_t mismatches = 0;
+    for (size_t p = 0; p < so.patterns.size(); p++)
+      if (so_result[p] != so_host_result[p]) {
+        std::cout << "pattern " << so.patterns[p] << " mismatch: device " << so_result[p]
+                  << ", host " << so_host_result[p] << std::endl;
+        mismatches++;
+      }
+    std::cout << "\n " << so.patterns.size() - mismatches << " of " << so.patterns.size()
+              << " pattern counts match the host results\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return mismatches == 0 ? 0 : 1;
+  }
+
+  if (keyword_file != NULL) {
+    std::cout << "\n results computed on device:\n";
+    for (size_t k = 0; k < ac.keywords.size(); k++)
+      std::cout << "keyword " << ac.keywords[k] << " appears " << ac_result[k] << " times" << std::endl;
+
+    std::vector<uint32_t> ac_host_result;
+    dpc_common::TimeInterval ac_exec_time;
+    ac_search_host(ac, text, text_size, ac_host_result);
+    double ac_host_time_s = ac_exec_time.Elapsed();
+    std::cout << "host compute time " << ac_host_time_s * 1000 << " ms\n";
+
+    size_t mismatches = 0;
+    for (size_t k = 0; k < ac.keywords.size(); k++)
+      if (ac_result[k] != ac_host_result[k]) {
+        std::cout << "keyword " << ac.keywords[k] << " mismatch: device " << ac_result[k]
+                  << ", host " << ac_host_result[k] << std::endl;
+        mismatches++;
+      }
+    std::cout << "\n " << ac.keywords.size() - mismatches << " of " << ac.keywords.size()
+              << " keyword counts match the host results\n";
+    if (use_mmap)
+      unmap_text_file(mapped);
+    return mismatches == 0 ? 0 : 1;
+  }
+
   // display final results in global memory
   std::cout << "\n results computed on device:\n";
   for(int i=0; i < NUM_KEYWORDS; i++)
@@ -314,13 +759,13 @@ int main(int argc, char **argv) {
 
   uint32_t host_result[NUM_KEYWORDS]={0,0,0,0};
   dpc_common::TimeInterval exec_time;
-  for(int i=0; i < text_size - 3; i++)
-    for(int k=0; k < NUM_KEYWORDS; k++)
-      if ( text[i] == keywords[k].x() &&
-           text[i+1] == keywords[k].y() &&
-           text[i+2] == keywords[k].z() &&
-           text[i+3] == keywords[k].w())
-	 host_result[k]++;
+  if (chunk_size != 0) {
+    rewind(text_handle);
+    stream_count_host(pattern, text_handle, text_size, chunk_size, host_result);
+    fclose(text_handle);
+  } else {
+    count_keywords_host(pattern, text, text_size, host_result, true);
+  }
   double host_time_s = exec_time.Elapsed();
   std::cout << "host compute time " << host_time_s * 1000 << " ms\n";
 
@@ -330,5 +775,7 @@ int main(int argc, char **argv) {
     std::cout << "keyword " << pattern[i][0]<<pattern[i][1]<<pattern[i][2]<<pattern[i][3] 
     << " appears " << host_result[i] << " times" << std::endl;
 
+  if (use_mmap)
+    unmap_text_file(mapped);
   return 0;
 }
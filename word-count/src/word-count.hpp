@@ -0,0 +1,82 @@
+//==============================================================
+// DPC++ Example
+//
+// Word Count with DPC++: definitions shared by the word count kernels
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __WORD_COUNT_HPP__
+#define __WORD_COUNT_HPP__
+
+#include <CL/sycl.hpp>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include "dpc_common.hpp"
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+#include <sycl/ext/intel/fpga_extensions.hpp>
+#endif
+
+using namespace sycl;
+
+#define TEXT_FILE "kafka.txt"
+// number of keywords to search
+#define NUM_KEYWORDS 4
+// length of the built-in keywords; a keyword starting in the last
+// KEYWORD_LEN-1 bytes of a chunk of text ends in the next one
+#define KEYWORD_LEN 4
+
+// work-group size of the search kernels and sub-group size of their
+// reductions; both can be set at build time, e.g. -DWG_SIZE=64
+#ifndef WG_SIZE
+#define WG_SIZE 16
+#endif
+#ifndef SUB_GROUP_SIZE
+#define SUB_GROUP_SIZE 8
+#endif
+constexpr unsigned MAX_WG_SIZE = WG_SIZE;
+// FPGA kernels vectorize at most 16 work-items, and the number must divide
+// the work-group size: the largest power of two up to 16 that divides it
+constexpr unsigned SIMD_WORK_ITEMS =
+  (MAX_WG_SIZE & -MAX_WG_SIZE) < 16 ? (MAX_WG_SIZE & -MAX_WG_SIZE) : 16;
+// FPGA kernels have no sub-groups to size
+#if FPGA || FPGA_EMULATOR || FPGA_PROFILE
+#define REQD_SUB_GROUP_SIZE
+#else
+#define REQD_SUB_GROUP_SIZE [[intel::reqd_sub_group_size(SUB_GROUP_SIZE)]]
+#endif
+//constexpr unsigned CHAR_PER_WORKITEM = 1024;
+
+// templates for atomic ref operations
+template <typename T>
+using local_atomic_ref = ext::oneapi::atomic_ref<
+  T,
+  ext::oneapi::memory_order::relaxed,
+  ext::oneapi::memory_scope::work_group,
+  access::address_space::local_space>;
+
+template <typename T>
+using global_atomic_ref = ext::oneapi::atomic_ref<
+  T,
+  ext::oneapi::memory_order::relaxed,
+  ext::oneapi::memory_scope::system,
+  access::address_space::global_space>;
+
+// parse a byte count such as "4096", "64K", "256M" or "2G"
+inline size_t parse_size(const char *arg) {
+  char *end;
+  size_t n = strtoull(arg, &end, 10);
+  switch (*end) {
+    case 'k': case 'K': n <<= 10; break;
+    case 'm': case 'M': n <<= 20; break;
+    case 'g': case 'G': n <<= 30; break;
+  }
+  return n;
+}
+
+#endif
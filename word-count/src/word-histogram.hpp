@@ -0,0 +1,404 @@
+//==============================================================
+// DPC++ Example
+//
+// Full vocabulary word frequency histogram for Word Count
+//
+// Every token of the text is counted in one pass over the text: work-items
+// tokenize their slice and insert the tokens into an open-addressing hash
+// table in global memory. Each work-group first aggregates its tokens in a
+// small hash table in local memory, so a frequent word costs one global
+// atomic per work-group rather than one per occurrence. The K most frequent
+// words are then picked by a parallel radix select over the table.
+//
+// Author: Yan Luo
+//
+// Copyright ©  2020-2021
+//
+// MIT License
+//
+//===============================================================
+#ifndef __WORD_HISTOGRAM_HPP__
+#define __WORD_HISTOGRAM_HPP__
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "word-count.hpp"
+
+// slots of the per work-group hash table in local memory
+constexpr size_t LOCAL_HASH_SLOTS = 1024;
+// probes into the local table before a token goes straight to global memory
+constexpr size_t LOCAL_HASH_PROBES = 8;
+// probes into the global table before it is considered full
+constexpr size_t GLOBAL_HASH_PROBES = 1024;
+// initial number of global hash table slots, doubled whenever it fills up
+constexpr size_t INITIAL_HASH_SLOTS = 1 << 20;
+
+// A token is a maximal run of letters, digits, '_' and non-ASCII bytes,
+// which keeps UTF-8 words and log identifiers in one piece.
+inline bool is_word_char(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+}
+
+// 64-bit FNV-1a; the hash doubles as the token's key in the tables, 0 marks
+// an empty slot
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+inline uint64_t finish_token_hash(uint64_t h) { return h == 0 ? 1 : h; }
+
+struct WordFreq {
+  std::string word;
+  uint32_t count;
+};
+
+struct VocabProfile {
+  uint64_t total_tokens = 0;
+  uint64_t distinct_tokens = 0;
+  std::vector<WordFreq> top;  // most frequent first
+};
+
+// order by decreasing count, ties alphabetically
+inline bool word_freq_before(const WordFreq &a, const WordFreq &b) {
+  return a.count != b.count ? a.count > b.count : a.word < b.word;
+}
+
+//************************************
+// Build the vocabulary hash table on device, returns false if it overflowed
+//************************************
+bool build_vocab_table(queue &q, uint32_t n_wgroups, int wgroup_size,
+  buffer<char,1> &text_buf, size_t text_size, size_t chars_per_item,
+  buffer<uint64_t,1> &keys_buf, buffer<uint32_t,1> &counts_buf,
+  buffer<uint64_t,1> &pos_buf, buffer<uint32_t,1> &lens_buf, uint64_t &total_tokens)
+{
+  size_t capacity = keys_buf.get_count();
+  uint32_t status[1] = {0};
+  uint64_t total[1] = {0};
+  {
+    buffer<uint32_t,1> status_buf(status, range<1>(1));
+    buffer<uint64_t,1> total_buf(total, range<1>(1));
+
+    q.submit([&] (handler& h) {
+      auto keys = keys_buf.get_access<access::mode::discard_write>(h);
+      h.fill(keys, (uint64_t)0);
+    });
+    q.submit([&] (handler& h) {
+      auto counts = counts_buf.get_access<access::mode::discard_write>(h);
+      h.fill(counts, (uint32_t)0);
+    });
+
+    event e = q.submit([&] (handler& h) {
+      // per work-group hash table in local memory
+      accessor<uint64_t, 1, access::mode::read_write, access::target::local>
+        local_keys(range<1>(LOCAL_HASH_SLOTS), h);
+      accessor<uint32_t, 1, access::mode::read_write, access::target::local>
+        local_counts(range<1>(LOCAL_HASH_SLOTS), h);
+      accessor<uint64_t, 1, access::mode::read_write, access::target::local>
+        local_pos(range<1>(LOCAL_HASH_SLOTS), h);
+      accessor<uint32_t, 1, access::mode::read_write, access::target::local>
+        local_lens(range<1>(LOCAL_HASH_SLOTS), h);
+      accessor<uint64_t, 1, access::mode::read_write, access::target::local>
+        local_total(range<1>(1), h);
+
+      auto text_mem = text_buf.get_access<access::mode::read>(h);
+      auto keys = keys_buf.get_access<access::mode::read_write>(h);
+      auto counts = counts_buf.get_access<access::mode::read_write>(h);
+      auto pos = pos_buf.get_access<access::mode::write>(h);
+      auto lens = lens_buf.get_access<access::mode::write>(h);
+      auto status_mem = status_buf.get_access<access::mode::read_write>(h);
+      auto total_mem = total_buf.get_access<access::mode::read_write>(h);
+      auto text_max_len = text_size;
+
+      h.parallel_for<class vocab_kernel>(
+        nd_range<1>(n_wgroups * wgroup_size, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          size_t local_id = item.get_local_id(0);
+          size_t local_size = item.get_local_range(0);
+
+          for (size_t s = local_id; s < LOCAL_HASH_SLOTS; s += local_size) {
+            local_keys[s] = 0;
+            local_counts[s] = 0;
+          }
+          if (local_id == 0)
+            local_total[0] = 0;
+          item.barrier(sycl::access::fence_space::local_space);
+
+          // add n occurrences of a token to the global table
+          auto insert_global = [&](uint64_t key, uint64_t start, uint32_t len, uint32_t n) {
+            size_t slot = key & (capacity - 1);
+            for (size_t p = 0; p < GLOBAL_HASH_PROBES; p++) {
+              uint64_t expected = 0;
+              if (global_atomic_ref<uint64_t>(keys[slot]).compare_exchange_strong(expected, key)) {
+                // the first inserter records where the token can be read back
+                pos[slot] = start;
+                lens[slot] = len;
+                global_atomic_ref<uint32_t>(counts[slot]) += n;
+                return;
+              }
+              if (expected == key) {
+                global_atomic_ref<uint32_t>(counts[slot]) += n;
+                return;
+              }
+              slot = (slot + 1) & (capacity - 1);
+            }
+            global_atomic_ref<uint32_t>(status_mem[0]).store(1);
+          };
+
+          // count one occurrence in the work-group's table, spilling to the
+          // global table when the local neighbourhood is full
+          auto insert_local = [&](uint64_t key, uint64_t start, uint32_t len) {
+            size_t slot = key & (LOCAL_HASH_SLOTS - 1);
+            for (size_t p = 0; p < LOCAL_HASH_PROBES; p++) {
+              uint64_t expected = 0;
+              if (local_atomic_ref<uint64_t>(local_keys[slot]).compare_exchange_strong(expected, key)) {
+                local_pos[slot] = start;
+                local_lens[slot] = len;
+                local_atomic_ref<uint32_t>(local_counts[slot])++;
+                return;
+              }
+              if (expected == key) {
+                local_atomic_ref<uint32_t>(local_counts[slot])++;
+                return;
+              }
+              slot = (slot + 1) & (LOCAL_HASH_SLOTS - 1);
+            }
+            insert_global(key, start, len, 1);
+          };
+
+          // this work-item owns the tokens that start inside its slice; a
+          // token running past the end of the slice is still read to its end
+          size_t begin = item.get_global_id(0) * chars_per_item;
+          size_t end = begin + chars_per_item;
+          if (end > text_max_len)
+            end = text_max_len;
+          uint64_t num_tokens = 0;
+          size_t i = begin;
+          if (i > 0 && i < end && is_word_char(text_mem[i - 1])) {
+            // skip the rest of a token owned by the previous slice
+            while (i < text_max_len && is_word_char(text_mem[i]))
+              i++;
+          }
+          while (i < end) {
+            if (!is_word_char(text_mem[i])) {
+              i++;
+              continue;
+            }
+            size_t start = i;
+            uint64_t h = FNV_OFFSET;
+            while (i < text_max_len && is_word_char(text_mem[i])) {
+              h = (h ^ (unsigned char)text_mem[i]) * FNV_PRIME;
+              i++;
+            }
+            insert_local(finish_token_hash(h), start, i - start);
+            num_tokens++;
+          }
+          local_atomic_ref<uint64_t>(local_total[0]) += num_tokens;
+
+          item.barrier(sycl::access::fence_space::local_space);
+
+          // merge the work-group's table into the global one
+          for (size_t s = local_id; s < LOCAL_HASH_SLOTS; s += local_size)
+            if (local_keys[s] != 0)
+              insert_global(local_keys[s], local_pos[s], local_lens[s], local_counts[s]);
+          if (local_id == 0)
+            global_atomic_ref<uint64_t>(total_mem[0]) += local_total[0];
+      }); // parallel_for
+    }); // q.submit
+#if FPGA || FPGA_PROFILE
+    double kernel_time_ns =
+      e.get_profiling_info<info::event_profiling::command_end>() -
+      e.get_profiling_info<info::event_profiling::command_start>();
+    std::cout << " Vocabulary kernel compute time:  " << kernel_time_ns * 1e-6 << " ms\n";
+#endif
+  }
+  total_tokens = total[0];
+  return status[0] == 0;
+}
+
+//************************************
+// Select the top_k most frequent slots of the table on device
+//************************************
+// Radix select on the 32-bit counts, 8 bits per pass from the most
+// significant digit down: each pass histograms the digit of the entries
+// still matching the chosen prefix, and the host picks the digit holding
+// the k-th largest count. After four passes the prefix is the k-th largest
+// count itself; one more kernel then gathers every entry above it plus as
+// many entries equal to it as are needed to make up k.
+std::vector<uint32_t> select_top_slots(queue &q, uint32_t n_wgroups, int wgroup_size,
+  buffer<uint64_t,1> &keys_buf, buffer<uint32_t,1> &counts_buf, size_t top_k,
+  uint64_t &distinct_tokens)
+{
+  constexpr int RADIX_BITS = 8;
+  constexpr int RADIX_BINS = 1 << RADIX_BITS;
+  size_t capacity = keys_buf.get_count();
+  size_t total_num_workitems = (size_t)n_wgroups * wgroup_size;
+
+  uint32_t prefix = 0, prefix_mask = 0;
+  size_t still_needed = top_k;
+  distinct_tokens = 0;
+  for (int shift = 32 - RADIX_BITS; shift >= 0; shift -= RADIX_BITS) {
+    uint32_t hist[RADIX_BINS] = {0};
+    {
+      buffer<uint32_t,1> hist_buf(hist, range<1>(RADIX_BINS));
+      q.submit([&] (handler& h) {
+        accessor<uint32_t, 1, access::mode::read_write, access::target::local>
+          local_hist(range<1>(RADIX_BINS), h);
+        auto keys = keys_buf.get_access<access::mode::read>(h);
+        auto counts = counts_buf.get_access<access::mode::read>(h);
+        auto hist_mem = hist_buf.get_access<access::mode::read_write>(h);
+
+        h.parallel_for<class topk_histogram_kernel>(
+          nd_range<1>(total_num_workitems, wgroup_size),
+          [=] (nd_item<1> item)
+          [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+          {
+            size_t local_id = item.get_local_id(0);
+            size_t local_size = item.get_local_range(0);
+            for (size_t b = local_id; b < RADIX_BINS; b += local_size)
+              local_hist[b] = 0;
+            item.barrier(sycl::access::fence_space::local_space);
+
+            for (size_t s = item.get_global_id(0); s < capacity; s += total_num_workitems)
+              if (keys[s] != 0 && (counts[s] & prefix_mask) == prefix)
+                local_atomic_ref<uint32_t>(local_hist[(counts[s] >> shift) & (RADIX_BINS - 1)])++;
+            item.barrier(sycl::access::fence_space::local_space);
+
+            for (size_t b = local_id; b < RADIX_BINS; b += local_size)
+              if (local_hist[b] != 0)
+                global_atomic_ref<uint32_t>(hist_mem[b]) += local_hist[b];
+        });
+      });
+    }
+
+    if (prefix_mask == 0) {
+      // the first pass sees every entry of the table
+      for (int b = 0; b < RADIX_BINS; b++)
+        distinct_tokens += hist[b];
+      still_needed = std::min<uint64_t>(top_k, distinct_tokens);
+      top_k = still_needed;
+      if (top_k == 0)
+        return std::vector<uint32_t>();
+    }
+
+    // walk the digits from the largest down to the one holding the k-th entry
+    int digit = RADIX_BINS - 1;
+    for (; digit > 0 && hist[digit] < still_needed; digit--)
+      still_needed -= hist[digit];
+    prefix |= (uint32_t)digit << shift;
+    prefix_mask |= (uint32_t)(RADIX_BINS - 1) << shift;
+  }
+
+  // gather the slots: all counts above the threshold, then still_needed ties
+  uint32_t threshold = prefix;
+  size_t num_above = top_k - still_needed;
+  std::vector<uint32_t> top_slots(top_k);
+  uint32_t fill[2] = {0, 0};
+  {
+    buffer<uint32_t,1> top_buf(top_slots.data(), range<1>(top_k));
+    buffer<uint32_t,1> fill_buf(fill, range<1>(2));
+    q.submit([&] (handler& h) {
+      auto keys = keys_buf.get_access<access::mode::read>(h);
+      auto counts = counts_buf.get_access<access::mode::read>(h);
+      auto top = top_buf.get_access<access::mode::write>(h);
+      auto fill_mem = fill_buf.get_access<access::mode::read_write>(h);
+
+      h.parallel_for<class topk_select_kernel>(
+        nd_range<1>(total_num_workitems, wgroup_size),
+        [=] (nd_item<1> item)
+        [[intel::max_work_group_size(1, 1, MAX_WG_SIZE)]]
+        {
+          for (size_t s = item.get_global_id(0); s < capacity; s += total_num_workitems) {
+            if (keys[s] == 0 || counts[s] < threshold)
+              continue;
+            if (counts[s] > threshold) {
+              top[global_atomic_ref<uint32_t>(fill_mem[0]).fetch_add(1)] = s;
+            } else {
+              uint32_t t = global_atomic_ref<uint32_t>(fill_mem[1]).fetch_add(1);
+              if (t < still_needed)
+                top[num_above + t] = s;
+            }
+          }
+      });
+    });
+  }
+  return top_slots;
+}
+
+//************************************
+// Word frequency profile of the whole vocabulary in DPC++ on device:
+//************************************
+void word_histogram(queue &q, uint32_t n_wgroups, int wgroup_size, const char *text,
+  size_t text_size, size_t chars_per_item, size_t top_k, VocabProfile &profile)
+{
+  auto local_mem_size = q.get_device().get_info<info::device::local_mem_size>();
+  if (local_mem_size < LOCAL_HASH_SLOTS * (2 * sizeof(uint64_t) + 2 * sizeof(uint32_t))) {
+    throw "Device doesn't have enough local memory for the word histogram!";
+  }
+
+  std::cout << std::endl << "n_wgroups = " << n_wgroups << std::endl;
+  std::cout << "wgroup_size = " << wgroup_size << std::endl;
+
+  buffer<char,1> text_buf(text, range<1>(text_size));
+  for (size_t capacity = INITIAL_HASH_SLOTS; ; capacity *= 2) {
+    buffer<uint64_t,1> keys_buf{range<1>(capacity)};
+    buffer<uint32_t,1> counts_buf{range<1>(capacity)};
+    buffer<uint64_t,1> pos_buf{range<1>(capacity)};
+    buffer<uint32_t,1> lens_buf{range<1>(capacity)};
+
+    if (!build_vocab_table(q, n_wgroups, wgroup_size, text_buf, text_size, chars_per_item,
+          keys_buf, counts_buf, pos_buf, lens_buf, profile.total_tokens)) {
+      std::cout << "hash table of " << capacity << " slots is full, retrying with "
+                << capacity * 2 << std::endl;
+      continue;
+    }
+    std::cout << "hash table slots = " << capacity << std::endl;
+
+    std::vector<uint32_t> top_slots = select_top_slots(q, n_wgroups, wgroup_size,
+      keys_buf, counts_buf, top_k, profile.distinct_tokens);
+
+    auto counts = counts_buf.get_access<access::mode::read>();
+    auto pos = pos_buf.get_access<access::mode::read>();
+    auto lens = lens_buf.get_access<access::mode::read>();
+    profile.top.clear();
+    for (auto s : top_slots)
+      profile.top.push_back({std::string(text + pos[s], lens[s]), counts[s]});
+    std::sort(profile.top.begin(), profile.top.end(), word_freq_before);
+    return;
+  }
+}
+
+//************************************
+// Word frequency profile on host, used to validate the device results
+//************************************
+void word_histogram_host(const char *text, size_t text_size, size_t top_k,
+  VocabProfile &profile)
+{
+  std::unordered_map<std::string, uint32_t> vocab;
+  profile.total_tokens = 0;
+  size_t i = 0;
+  while (i < text_size) {
+    if (!is_word_char(text[i])) {
+      i++;
+      continue;
+    }
+    size_t start = i;
+    while (i < text_size && is_word_char(text[i]))
+      i++;
+    vocab[std::string(text + start, i - start)]++;
+    profile.total_tokens++;
+  }
+  profile.distinct_tokens = vocab.size();
+
+  profile.top.clear();
+  for (auto &w : vocab)
+    profile.top.push_back({w.first, w.second});
+  top_k = std::min(top_k, profile.top.size());
+  std::partial_sort(profile.top.begin(), profile.top.begin() + top_k, profile.top.end(),
+    word_freq_before);
+  profile.top.resize(top_k);
+}
+
+#endif